@@ -0,0 +1,475 @@
+// CekyMonitor Bench - collector micro-benchmarks over synthetic procfs trees
+//
+//   bench --generate DIR [--pids N] [--cores N] [--disks N] [--ifaces N] [--cgroups N]
+//       Writes a deterministic fixture tree: DIR/proc/{stat,schedstat,meminfo,diskstats,net/dev,pressure/*,
+//       <pid>/{stat,io,schedstat},...} and DIR/sys/..., plus DIR/fixture.txt describing it.
+//   bench [--min-time SECONDS] FIXTURE_DIR...
+//       Points the collectors at each fixture (setHostRoots) and reports ns/op,
+//       allocations/op and syscalls/op for the hot collectors.
+//
+// `make bench` generates the 1k / 10k / 100k pid fixtures once under build/fixtures.
+
+#include "../src/collectors.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/stat.h>
+
+// ==================== FIXTURE GENERATOR ====================
+struct FixtureSpec {
+    int pids = 1000;
+    int cores = 8;
+    int disks = 8;
+    int ifaces = 4;
+    int cgroups = 32;
+};
+
+// xorshift64: fixtures must be identical on every run.
+struct Rng {
+    unsigned long long state = 0x9E3779B97F4A7C15ULL;
+    unsigned long long next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+    long long range(long long lo, long long hi) { return lo + (long long)(next() % (unsigned long long)(hi - lo + 1)); }
+};
+
+static bool makeDirs(const std::string& path) {
+    for (size_t i = 1; i <= path.size(); i++) {
+        if (i < path.size() && path[i] != '/') continue;
+        std::string part = path.substr(0, i);
+        if (mkdir(part.c_str(), 0755) != 0 && errno != EEXIST) {
+            fprintf(stderr, "mkdir %s: %s\n", part.c_str(), strerror(errno));
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool writeFile(const std::string& path, const std::string& content) {
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) {
+        fprintf(stderr, "open %s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+    fwrite(content.data(), 1, content.size(), f);
+    return fclose(f) == 0;
+}
+
+static void appendf(std::string& out, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+static void appendf(std::string& out, const char* fmt, ...) {
+    char buf[1024];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    if (n > 0) out.append(buf, std::min(n, (int)sizeof(buf) - 1));
+}
+
+static std::string diskName(int i) {
+    // sda..sdz, sdaa.. for SATA/SCSI and every fourth disk as NVMe
+    if (i % 4 == 3) return "nvme" + std::to_string(i / 4) + "n1";
+    std::string name = "sd";
+    int n = i - i / 4;
+    if (n >= 26) name += (char)('a' + n / 26 - 1);
+    name += (char)('a' + n % 26);
+    return name;
+}
+
+static std::string diskstatsLine(Rng& rng, int major, int minor, const std::string& name) {
+    std::string line;
+    appendf(line, "%4d %7d %s", major, minor, name.c_str());
+    for (int f = 0; f < 17; f++) appendf(line, " %lld", rng.range(0, 50000000));
+    line += '\n';
+    return line;
+}
+
+static bool generateFixture(const std::string& dir, const FixtureSpec& spec) {
+    Rng rng;
+    std::string proc = dir + "/proc", sys = dir + "/sys";
+    if (!makeDirs(proc + "/net") || !makeDirs(proc + "/sys/fs")) return false;
+
+    // /proc/stat
+    std::string stat;
+    auto cpuLine = [&](const char* label) {
+        appendf(stat, "%s %lld %lld %lld %lld %lld %lld %lld %lld 0 0\n", label,
+                rng.range(1e5, 1e8), rng.range(0, 1e5), rng.range(1e5, 1e7), rng.range(1e6, 1e9),
+                rng.range(0, 1e6), rng.range(0, 1e5), rng.range(0, 1e5), rng.range(0, 1e4));
+    };
+    cpuLine("cpu ");
+    for (int c = 0; c < spec.cores; c++) {
+        char label[16];
+        snprintf(label, sizeof(label), "cpu%d", c);
+        cpuLine(label);
+    }
+    stat += "intr 123456789";
+    for (int i = 0; i < 256; i++) appendf(stat, " %lld", rng.range(0, 100000));
+    stat += "\nctxt 987654321\nbtime 1700000000\nprocesses 1234567\n";
+    appendf(stat, "procs_running %d\nprocs_blocked 0\n", std::max(1, spec.cores / 4));
+    stat += "softirq 55555555 0 1 2 3 4 5 6 7 8 9\n";
+    if (!writeFile(proc + "/stat", stat)) return false;
+
+    // /proc/schedstat (version 15): a cpu line plus two sched domain lines per CPU
+    std::string schedstat = "version 15\ntimestamp 4299999999\n";
+    for (int c = 0; c < spec.cores; c++) {
+        long long run = rng.range(1e12, 1e14);
+        appendf(schedstat, "cpu%d 0 0 %lld %lld %lld %lld %lld %lld %lld\n", c, rng.range(1e6, 1e9), rng.range(1e5, 1e8),
+                rng.range(1e6, 1e9), rng.range(1e5, 1e8), run, run / rng.range(5, 50), rng.range(1e6, 1e9));
+        for (int d = 0; d < 2; d++) {
+            appendf(schedstat, "domain%d %s", d, d ? "ffffffff" : "00000003");
+            for (int f = 0; f < 45; f++) appendf(schedstat, " %lld", rng.range(0, 1e6));
+            schedstat += '\n';
+        }
+    }
+    if (!writeFile(proc + "/schedstat", schedstat)) return false;
+
+    // /proc/meminfo (full field list, as the kernel prints it)
+    static const char* const memFields[] = {
+        "MemTotal", "MemFree", "MemAvailable", "Buffers", "Cached", "SwapCached", "Active", "Inactive",
+        "Active(anon)", "Inactive(anon)", "Active(file)", "Inactive(file)", "Unevictable", "Mlocked",
+        "SwapTotal", "SwapFree", "Zswap", "Zswapped", "Dirty", "Writeback", "AnonPages", "Mapped", "Shmem",
+        "KReclaimable", "Slab", "SReclaimable", "SUnreclaim", "KernelStack", "PageTables", "SecPageTables",
+        "NFS_Unstable", "Bounce", "WritebackTmp", "CommitLimit", "Committed_AS", "VmallocTotal", "VmallocUsed",
+        "VmallocChunk", "Percpu", "HardwareCorrupted", "AnonHugePages", "ShmemHugePages", "ShmemPmdMapped",
+        "FileHugePages", "FilePmdMapped", "Unaccepted", "HugePages_Total", "HugePages_Free", "HugePages_Rsvd",
+        "HugePages_Surp", "Hugepagesize", "Hugetlb", "DirectMap4k", "DirectMap2M", "DirectMap1G",
+    };
+    std::string meminfo;
+    for (const char* field : memFields)
+        appendf(meminfo, "%-16s%8lld kB\n", (std::string(field) + ":").c_str(), rng.range(0, 64LL * 1024 * 1024));
+    if (!writeFile(proc + "/meminfo", meminfo)) return false;
+
+    // /proc/net/dev
+    std::string netdev =
+        "Inter-|   Receive                                                |  Transmit\n"
+        " face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets errs drop fifo colls carrier compressed\n";
+    auto netLine = [&](const std::string& name) {
+        appendf(netdev, "%6s:", name.c_str());
+        for (int f = 0; f < 16; f++) appendf(netdev, " %lld", rng.range(0, 1LL << 40));
+        netdev += '\n';
+    };
+    netLine("lo");
+    std::vector<std::string> nics; // backed by a device in sysfs
+    for (int i = 0; i < spec.ifaces; i++) {
+        if (i % 3 == 0) nics.push_back("eth" + std::to_string(i / 3));
+        else if (i % 3 == 1) netLine("veth" + std::to_string(i));
+        else nics.push_back("wlan" + std::to_string(i / 3));
+        if (i % 3 != 1) netLine(nics.back());
+    }
+    if (!writeFile(proc + "/net/dev", netdev)) return false;
+    for (const std::string& nic : nics)
+        if (!makeDirs(sys + "/class/net/" + nic + "/device")) return false;
+
+    // /proc/diskstats: loop devices, then every disk followed by two partitions
+    std::string diskstats;
+    // /sys/block lists whole disks only; physical ones carry a device link.
+    for (int i = 0; i < 8; i++) {
+        diskstats += diskstatsLine(rng, 7, i, "loop" + std::to_string(i));
+        if (!makeDirs(sys + "/block/loop" + std::to_string(i))) return false;
+    }
+    for (int i = 0; i < spec.disks; i++) {
+        std::string name = diskName(i);
+        if (!makeDirs(sys + "/block/" + name + "/device")) return false;
+        bool nvme = name.compare(0, 4, "nvme") == 0;
+        int major = nvme ? 259 : 8 + (i / 16);
+        diskstats += diskstatsLine(rng, major, (i % 16) * 16, name);
+        for (int part = 1; part <= 2; part++)
+            diskstats += diskstatsLine(rng, major, (i % 16) * 16 + part, name + (nvme ? "p" : "") + std::to_string(part));
+    }
+    if (!writeFile(proc + "/diskstats", diskstats)) return false;
+
+    if (!writeFile(proc + "/uptime", "123456.78 456789.01\n")) return false;
+    if (!writeFile(proc + "/loadavg", "1.23 0.98 0.76 3/1234 56789\n")) return false;
+    if (!makeDirs(proc + "/pressure")) return false;
+    for (const char* resource : {"cpu", "memory", "io"}) {
+        std::string psi;
+        appendf(psi, "some avg10=%.2f avg60=%.2f avg300=%.2f total=%lld\nfull avg10=0.00 avg60=0.00 avg300=0.00 total=%lld\n",
+                rng.range(0, 2000) / 100.0, rng.range(0, 2000) / 100.0, rng.range(0, 2000) / 100.0, rng.range(0, 1e11),
+                rng.range(0, 1e10));
+        if (!writeFile(proc + "/pressure/" + resource, psi)) return false;
+    }
+    if (!writeFile(proc + "/sys/fs/file-nr", "12345\t0\t9223372036854775807\n")) return false;
+
+    // /proc/[pid]/stat: realistic 52-field lines, comm with spaces and parentheses included
+    static const char* const comms[] = {
+        "systemd", "kworker/0:1-events", "bash", "Web Content", "(sd-pam)", "chrome", "Xorg",
+        "pipewire", "sshd", "python3", "a) b (c", "containerd-shim", "node", "postgres", "rcu_sched",
+    };
+    static const char states[] = "SSSSSRDIZ";
+    for (int i = 0; i < spec.pids; i++) {
+        int pid = 1 + i * 3;
+        std::string pidDir = proc + "/" + std::to_string(pid);
+        if (mkdir(pidDir.c_str(), 0755) != 0 && errno != EEXIST) {
+            fprintf(stderr, "mkdir %s: %s\n", pidDir.c_str(), strerror(errno));
+            return false;
+        }
+        std::string line;
+        appendf(line, "%d (%s) %c %d %d %d 0 -1 4194560 %lld 0 %lld 0 %lld %lld 0 0 20 0 %lld 0 %lld %lld %lld "
+                      "18446744073709551615 1 1 0 0 0 0 0 0 0 0 0 0 17 %lld 0 0 0 0 0 0 0 0 0 0 0 0 0\n",
+                pid, comms[rng.next() % (sizeof(comms) / sizeof(comms[0]))], states[rng.next() % 9],
+                i ? (int)rng.range(1, pid) : 0, pid, pid,
+                rng.range(0, 1e6), rng.range(0, 1e3), rng.range(0, 1e7), rng.range(0, 1e6),
+                rng.range(1, 64), rng.range(0, 1e8), rng.range(1e6, 1e10), rng.range(100, 1e6),
+                rng.range(0, spec.cores - 1));
+        if (!writeFile(pidDir + "/stat", line)) return false;
+
+        std::string io;
+        long long readBytes = rng.range(0, 1e10), writeBytes = rng.range(0, 1e10);
+        appendf(io, "rchar: %lld\nwchar: %lld\nsyscr: %lld\nsyscw: %lld\nread_bytes: %lld\nwrite_bytes: %lld\n"
+                    "cancelled_write_bytes: %lld\n",
+                readBytes + rng.range(0, 1e9), writeBytes + rng.range(0, 1e9), rng.range(0, 1e7), rng.range(0, 1e7),
+                readBytes, writeBytes, rng.range(0, 1e6));
+        if (!writeFile(pidDir + "/io", io)) return false;
+
+        std::string sched;
+        appendf(sched, "%lld %lld %lld\n", rng.range(0, 1e12), rng.range(0, 1e11), rng.range(0, 1e7));
+        if (!writeFile(pidDir + "/schedstat", sched)) return false;
+    }
+
+    // A few sysfs nodes the per-tick collectors read
+    if (!makeDirs(sys + "/class/thermal/thermal_zone0") ||
+        !makeDirs(sys + "/devices/system/cpu/cpu0/cpufreq")) return false;
+    if (!writeFile(sys + "/class/thermal/thermal_zone0/temp", "54000\n")) return false;
+    if (!writeFile(sys + "/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq", "2400000\n")) return false;
+    if (!writeFile(sys + "/devices/system/cpu/cpu0/cpufreq/cpuinfo_max_freq", "4800000\n")) return false;
+
+    // cgroup v2 tree: half services under system.slice, half pod containers under
+    // kubepods.slice; every fifth group is empty (not populated).
+    std::string cg = sys + "/fs/cgroup";
+    auto writeGroup = [&](const std::string& dir, bool populated) {
+        if (!makeDirs(dir)) return false;
+        std::string cpu, io, memStat;
+        long long usage = rng.range(0, 1e12);
+        appendf(cpu, "usage_usec %lld\nuser_usec %lld\nsystem_usec %lld\nnr_periods 0\nnr_throttled 0\nthrottled_usec 0\n",
+                usage, usage / 3 * 2, usage / 3);
+        appendf(io, "8:0 rbytes=%lld wbytes=%lld rios=%lld wios=%lld dbytes=0 dios=0\n",
+                rng.range(0, 1e11), rng.range(0, 1e11), rng.range(0, 1e8), rng.range(0, 1e8));
+        appendf(io, "253:0 rbytes=%lld wbytes=%lld rios=%lld wios=%lld dbytes=0 dios=0\n",
+                rng.range(0, 1e11), rng.range(0, 1e11), rng.range(0, 1e8), rng.range(0, 1e8));
+        long long anon = rng.range(0, 1e10), file = rng.range(0, 1e10);
+        appendf(memStat, "anon %lld\nfile %lld\nkernel 1048576\nkernel_stack 65536\npagetables 131072\nsock 0\nshmem 0\n"
+                         "file_mapped %lld\nfile_dirty 0\nfile_writeback 0\nanon_thp 0\ninactive_anon %lld\nactive_anon %lld\n"
+                         "inactive_file %lld\nactive_file %lld\nunevictable 0\nslab_reclaimable 0\nslab_unreclaimable 0\n",
+                anon, file, file / 4, anon / 2, anon / 2, file / 2, file / 2);
+        char num[32];
+        snprintf(num, sizeof(num), "%lld\n", anon + file);
+        std::string pids = std::to_string(populated ? rng.range(1, 200) : 0) + "\n";
+        for (const char* resource : {"cpu", "memory", "io"}) {
+            std::string psi;
+            appendf(psi, "some avg10=0.00 avg60=0.00 avg300=0.00 total=%lld\nfull avg10=0.00 avg60=0.00 avg300=0.00 total=0\n",
+                    rng.range(0, 1e10));
+            if (!writeFile(dir + "/" + resource + ".pressure", psi)) return false;
+        }
+        return writeFile(dir + "/cgroup.events", populated ? "populated 1\nfrozen 0\n" : "populated 0\nfrozen 0\n") &&
+               writeFile(dir + "/cpu.stat", cpu) && writeFile(dir + "/io.stat", io) &&
+               writeFile(dir + "/memory.current", num) && writeFile(dir + "/memory.stat", memStat) &&
+               writeFile(dir + "/pids.current", pids);
+    };
+    if (!makeDirs(cg) || !writeFile(cg + "/cgroup.controllers", "cpuset cpu io memory hugetlb pids rdma misc\n")) return false;
+    if (spec.cgroups > 0 && (!writeGroup(cg + "/system.slice", true) || !writeGroup(cg + "/kubepods.slice", true))) return false;
+    for (int i = 0; i < spec.cgroups; i++) {
+        std::string dir = i % 2 == 0 ? cg + "/system.slice/svc" + std::to_string(i / 2) + ".service"
+                                     : cg + "/kubepods.slice/pod" + std::to_string(i / 8) + "/ctr" + std::to_string(i / 2 % 4);
+        if (i % 8 == 1 && !writeGroup(cg + "/kubepods.slice/pod" + std::to_string(i / 8), true)) return false;
+        if (!writeGroup(dir, i % 5 != 0)) return false;
+    }
+
+    // Written last: its presence marks a complete fixture.
+    char desc[128];
+    snprintf(desc, sizeof(desc), "pids=%d cores=%d disks=%d ifaces=%d cgroups=%d\n", spec.pids, spec.cores, spec.disks,
+             spec.ifaces, spec.cgroups);
+    return writeFile(dir + "/fixture.txt", desc);
+}
+
+// ==================== BENCHMARK RUNNER ====================
+struct BenchResult {
+    double nsPerOp, allocsPerOp, syscallsPerOp;
+    long long iterations;
+};
+
+// One warm-up call (opens sources, sizes buffers), then doubling batches until
+// minTime has elapsed so the clock is read once per batch, not per op.
+template <typename Op>
+static BenchResult runBench(Op&& op, double minTime) {
+    op();
+    PerfCounters before = perfThreadCounters;
+    long long start = monotonicNanos(), elapsed = 0, iterations = 0;
+    for (long long batch = 1; elapsed < minTime * 1e9; batch *= 2) {
+        for (long long i = 0; i < batch; i++) op();
+        iterations += batch;
+        elapsed = monotonicNanos() - start;
+    }
+    BenchResult r;
+    r.iterations = iterations;
+    r.nsPerOp = (double)elapsed / iterations;
+    r.allocsPerOp = (double)(perfThreadCounters.allocations - before.allocations) / iterations;
+    r.syscallsPerOp = (double)(perfThreadCounters.syscalls - before.syscalls) / iterations;
+    return r;
+}
+
+static void report(const char* name, const BenchResult& r) {
+    printf("  %-24s %14.1f %12.2f %12.1f %12lld\n", name, r.nsPerOp, r.allocsPerOp, r.syscallsPerOp, r.iterations);
+}
+
+// Field by field: ProcRecord has padding, so memcmp would compare garbage.
+static bool sameRecords(const std::vector<ProcRecord>& a, const std::vector<ProcRecord>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        const ProcRecord& x = a[i];
+        const ProcRecord& y = b[i];
+        if (x.pid != y.pid || x.ppid != y.ppid || x.state != y.state || strcmp(x.comm, y.comm) != 0 ||
+            x.utime != y.utime || x.stime != y.stime || x.minflt != y.minflt || x.majflt != y.majflt ||
+            x.starttime != y.starttime || x.rss != y.rss || x.numThreads != y.numThreads || x.processor != y.processor)
+            return false;
+    }
+    return true;
+}
+
+static void benchFixture(const std::string& dir, double minTime) {
+    char desc[128] = "";
+    if (FILE* f = fopen((dir + "/fixture.txt").c_str(), "r")) {
+        if (!fgets(desc, sizeof(desc), f)) desc[0] = 0;
+        fclose(f);
+    }
+    desc[strcspn(desc, "\n")] = 0;
+    printf("\n%s  (%s)\n", dir.c_str(), desc[0] ? desc : "no fixture.txt");
+    printf("  %-24s %14s %12s %12s %12s\n", "benchmark", "ns/op", "allocs/op", "syscalls/op", "iterations");
+
+    setHostRoots(dir + "/proc", dir + "/sys");
+
+    ProcStatSnapshot oldStat = {}, newStat = {};
+    readProcStatSnapshot(oldStat);
+    std::vector<float> coreUsage;
+    report("per-core CPU", runBench([&] {
+        readProcStatSnapshot(newStat);
+        const std::vector<CPUStats>& oldCores = readPerCoreCPUStats(oldStat);
+        const std::vector<CPUStats>& newCores = readPerCoreCPUStats(newStat);
+        coreUsage.resize(newCores.size());
+        for (size_t i = 0; i < newCores.size() && i < oldCores.size(); i++)
+            coreUsage[i] = calcCPUUsage(oldCores[i], newCores[i]);
+    }, minTime));
+
+    report("getMemoryDetail", runBench([] { getMemoryDetail(); }, minTime));
+    report("readNetStats", runBench([] { readNetStats(); }, minTime));
+    std::vector<NetInterfaceStats> ifaces;
+    report("readNetInterfaces", runBench([&] { readNetInterfaces(ifaces); }, minTime));
+    report("readDiskStats", runBench([] { readDiskStats(); }, minTime));
+    std::vector<BlockDeviceStats> blocks;
+    report("readBlockDevices", runBench([&] { readBlockDevices(blocks); }, minTime));
+    SystemPressure pressure = {};
+    report("readSystemPressure", runBench([&] { readSystemPressure(pressure); }, minTime));
+    std::vector<CpuSchedStat> schedStats;
+    report("readSchedStat", runBench([&] { readSchedStat(schedStats); }, minTime));
+
+    // Steady state: the tree is walked by the warm-up call, then only read.
+    CgroupCollector cgroups;
+    std::vector<CgroupInfo> groups;
+    double cgroupNow = 0;
+    report("CgroupCollector::update", runBench([&] { cgroups.update(groups, cgroupNow += 1); }, minTime));
+
+    std::vector<ProcRecord> records;
+    report("readAllProcTicks", runBench([&] { readAllProcTicks(records); }, minTime));
+
+    for (int threads : {2, 4, 8}) {
+        ProcWalker walker(threads);
+        std::vector<ProcRecord> parallel;
+        char name[32];
+        snprintf(name, sizeof(name), "ProcWalker x%d", threads);
+        report(name, runBench([&] { walker.walk(parallel); }, minTime));
+        if (!sameRecords(records, parallel)) printf("  !! %s differs from readAllProcTicks\n", name);
+
+        // A small pid set after a parallel-sized walk (as with --proc-events, or
+        // a host whose pid count dropped) must not pick up the walk's slices.
+        std::vector<int> subset;
+        for (size_t i = 0; i < records.size() && subset.size() < 100; i += 7) subset.push_back(records[i].pid);
+        ProcWalker serial(1);
+        std::vector<ProcRecord> expected;
+        serial.read(subset, expected);
+        walker.walk(parallel);
+        walker.read(subset, parallel);
+        if (!sameRecords(expected, parallel)) printf("  !! %s read() of %zu pids after walk() differs from a serial read\n", name, subset.size());
+    }
+
+    // Previous tick with pseudo-random lower tick counts, so every process has a
+    // non-zero delta and the top-K heap actually churns.
+    std::vector<ProcRecord> older = records;
+    Rng rng;
+    for (ProcRecord& r : older) {
+        r.utime = std::max(0LL, (long long)r.utime - rng.range(0, 200));
+        r.stime = std::max(0LL, (long long)r.stime - rng.range(0, 50));
+    }
+    ProcTickTable oldTicks;
+    oldTicks.rebuild(older);
+    report("getTopProcesses", runBench([&] { getTopProcesses(oldTicks, records, 100000, 25); }, minTime));
+    // Every process has a CPU delta, so this is the worst case: io read for all of them.
+    ProcIoTracker io;
+    double now = 0;
+    report("ProcIoTracker (all active)", runBench([&] { io.update(oldTicks, records, now += 1); }, minTime));
+    ProcSchedTracker sched;
+    report("ProcSchedTracker (all)", runBench([&] { sched.update(oldTicks, records, now += 1); }, minTime));
+}
+
+// One op is one sampler wake-up: jump to the next deadline and re-arm whatever
+// expired, with a collector-like mix of 12 timers from 0.1 s to 30 s.
+static void benchScheduler(double minTime) {
+    printf("\nscheduler\n");
+    printf("  %-24s %14s %12s %12s %12s\n", "benchmark", "ns/op", "allocs/op", "syscalls/op", "iterations");
+    const double intervals[] = {0.1, 0.1, 1, 0.1, 1, 1, 1, 1, 1, 5, 30, 30};
+    const int count = (int)(sizeof(intervals) / sizeof(intervals[0]));
+    double deadlines[count];
+    TimerWheel wheel(0);
+    for (int id = 0; id < count; id++) wheel.arm(id, deadlines[id] = intervals[id]);
+    report("TimerWheel wake-up", runBench([&] {
+        double now = wheel.nextExpiry();
+        unsigned expired = wheel.advance(now);
+        for (int id = 0; id < count; id++)
+            if (expired & (1u << id)) wheel.arm(id, deadlines[id] += intervals[id]);
+    }, minTime));
+}
+
+// ==================== MAIN ====================
+int main(int argc, char** argv) {
+    FixtureSpec spec;
+    std::string generateDir;
+    double minTime = 0.5;
+    std::vector<std::string> fixtures;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--generate" && i + 1 < argc) generateDir = argv[++i];
+        else if (arg == "--pids" && i + 1 < argc) spec.pids = std::max(1, atoi(argv[++i]));
+        else if (arg == "--cores" && i + 1 < argc) spec.cores = std::max(1, atoi(argv[++i]));
+        else if (arg == "--disks" && i + 1 < argc) spec.disks = std::max(0, atoi(argv[++i]));
+        else if (arg == "--ifaces" && i + 1 < argc) spec.ifaces = std::max(0, atoi(argv[++i]));
+        else if (arg == "--cgroups" && i + 1 < argc) spec.cgroups = std::max(0, atoi(argv[++i]));
+        else if (arg == "--min-time" && i + 1 < argc) minTime = std::max(0.01, atof(argv[++i]));
+        else if (arg == "--help" || arg == "-h") {
+            printf("Usage: bench --generate DIR [--pids N] [--cores N] [--disks N] [--ifaces N] [--cgroups N]\n"
+                   "       bench [--min-time SECONDS] FIXTURE_DIR...\n");
+            return 0;
+        } else if (!arg.empty() && arg[0] == '-') {
+            fprintf(stderr, "Unknown option: %s\n", arg.c_str());
+            return 2;
+        } else fixtures.push_back(arg);
+    }
+
+    if (!generateDir.empty()) {
+        printf("Generating %s (%d pids, %d cores, %d disks, %d interfaces, %d cgroups)...\n",
+               generateDir.c_str(), spec.pids, spec.cores, spec.disks, spec.ifaces, spec.cgroups);
+        fflush(stdout);
+        return generateFixture(generateDir, spec) ? 0 : 1;
+    }
+    if (fixtures.empty()) {
+        fprintf(stderr, "No fixture directories given (see --help)\n");
+        return 2;
+    }
+    benchScheduler(minTime);
+    for (const std::string& dir : fixtures) benchFixture(dir, minTime);
+    return 0;
+}
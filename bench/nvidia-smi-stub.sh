@@ -0,0 +1,33 @@
+#!/bin/sh
+# Stand-in for `nvidia-smi --query-gpu=... --format=csv,noheader,nounits --loop-ms=N`
+# on machines without an NVIDIA GPU:  monitor --nvidia-smi bench/nvidia-smi-stub.sh
+# Prints GPUS (default 2) CSV lines every N ms; GPU 1 reports [N/A] for fan and power
+# like a datacenter card would.
+
+period=1000
+for arg in "$@"; do
+    case "$arg" in
+        --loop-ms=*) period=${arg#--loop-ms=} ;;
+        -lms=*) period=${arg#-lms=} ;;
+    esac
+done
+gpus=${GPUS:-2}
+delay=$(awk "BEGIN { print $period / 1000 }")
+
+tick=0
+while :; do
+    i=0
+    while [ "$i" -lt "$gpus" ]; do
+        usage=$(( (tick * 7 + i * 31) % 100 ))
+        temp=$(( 40 + (tick + i * 5) % 35 ))
+        used=$(( 1024 + (tick * 128 + i * 512) % 8192 ))
+        if [ $(( i % 2 )) -eq 0 ]; then
+            echo "$i, Stub GeForce RTX $(( 4070 + i * 10 )), $temp, $usage, $used, 12288, $(( 30 + usage / 2 )), $(( 50 + usage * 2 )).25"
+        else
+            echo "$i, Stub Tesla T4, $temp, $usage, $used, 15360, [N/A], [Not Supported]"
+        fi
+        i=$(( i + 1 ))
+    done
+    tick=$(( tick + 1 ))
+    sleep "$delay"
+done
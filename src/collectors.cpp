@@ -0,0 +1,3614 @@
+// CekyMonitor - Linux data collection
+// Everything that reads /proc and /sys lives here; see collectors.h.
+
+#include "collectors.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <string_view>
+#include <unordered_map>
+#include <deque>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <iterator>
+#include <chrono>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cctype>
+#include <cstring>
+#include <new>
+#include <dirent.h>
+#include <signal.h>
+#include <spawn.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <sys/statvfs.h>
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+#include <time.h>
+#include <pwd.h>
+#include <linux/netlink.h>
+#include <linux/connector.h>
+#include <linux/cn_proc.h>
+#include <linux/rtnetlink.h>
+#include <linux/if_link.h>
+#include <linux/sock_diag.h>
+#include <linux/inet_diag.h>
+#include <linux/unix_diag.h>
+#include <netinet/in.h>
+#include <net/if.h>
+
+// ==================== PROCFS PARSING ====================
+// Minimal scanners over a raw file buffer. They never allocate, so a reader can
+// parse a whole /proc file in place instead of going through getline + stringstream.
+static inline const char* skipSpaces(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    return p;
+}
+
+static inline const char* skipLine(const char* p, const char* end) {
+    const char* nl = (const char*)memchr(p, '\n', end - p);
+    return nl ? nl + 1 : end;
+}
+
+static inline long long parseLL(const char*& p, const char* end) {
+    p = skipSpaces(p, end);
+    bool neg = false;
+    if (p < end && *p == '-') { neg = true; p++; }
+    unsigned long long v = 0; // unsigned: some fields (e.g. rsslim) are ULLONG_MAX
+    while (p < end && *p >= '0' && *p <= '9') v = v * 10 + (*p++ - '0');
+    return neg ? -(long long)v : (long long)v;
+}
+
+static inline bool startsWith(const char* p, const char* end, const char* lit) {
+    size_t n = strlen(lit);
+    return (size_t)(end - p) >= n && memcmp(p, lit, n) == 0;
+}
+
+double monotonicSeconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+long long monotonicNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static inline double parseDouble(const char*& p, const char* end) {
+    p = skipSpaces(p, end);
+    bool neg = false;
+    if (p < end && *p == '-') { neg = true; p++; }
+    double v = 0;
+    while (p < end && *p >= '0' && *p <= '9') v = v * 10 + (*p++ - '0');
+    if (p < end && *p == '.') {
+        p++;
+        double scale = 0.1;
+        while (p < end && *p >= '0' && *p <= '9') { v += (*p++ - '0') * scale; scale *= 0.1; }
+    }
+    return neg ? -v : v;
+}
+
+// ==================== HOST ROOTS ====================
+static std::string procRootDir = "/proc";
+static std::string sysRootDir = "/sys";
+static unsigned hostRootsGeneration = 0; // bumped by setHostRoots()
+
+// /proc/self describes the monitor process itself, so it is never remapped.
+std::string hostPath(const std::string& path) {
+    if (path.compare(0, 6, "/proc/") == 0 && path.compare(0, 11, "/proc/self/") != 0)
+        return procRootDir + path.substr(5);
+    if (path == "/proc") return procRootDir;
+    if (path.compare(0, 5, "/sys/") == 0) return sysRootDir + path.substr(4);
+    if (path == "/sys") return sysRootDir;
+    return path;
+}
+
+// Whether PREFIX + name + SUFFIX exists, cached per device name so a collector
+// pays one access() per device rather than one per tick. Sysfs spells '/' in
+// block device names as '!'. Forgets everything when the host roots change.
+class SysfsNameCache {
+public:
+    SysfsNameCache(const char* prefix, const char* suffix) : prefix(prefix), suffix(suffix) {}
+
+    bool exists(const std::string& name) {
+        if (generation != hostRootsGeneration) {
+            cache.clear();
+            generation = hostRootsGeneration;
+        }
+        auto it = cache.find(name);
+        if (it != cache.end()) return it->second;
+        std::string path = prefix + name + suffix;
+        std::replace(path.begin() + strlen(prefix), path.end() - strlen(suffix), '/', '!');
+        countSyscalls();
+        bool found = access(hostPath(path).c_str(), F_OK) == 0;
+        cache.emplace(name, found);
+        return found;
+    }
+
+private:
+    const char* prefix;
+    const char* suffix;
+    unsigned generation = ~0u;
+    std::unordered_map<std::string, bool> cache;
+};
+
+// ==================== CACHED SOURCES ====================
+static std::unordered_map<std::string, std::unique_ptr<ProcSource>>& sourceRegistry() {
+    static std::unordered_map<std::string, std::unique_ptr<ProcSource>> registry;
+    return registry;
+}
+
+// Returns the registry entry for path, creating it on first use. Entries are never
+// destroyed, so callers can hold on to the reference (typically in a static local).
+ProcSource& procSource(const std::string& path) {
+    std::unique_ptr<ProcSource>& slot = sourceRegistry()[path];
+    if (!slot) {
+        slot.reset(new ProcSource());
+        slot->key = path;
+        slot->path = hostPath(path);
+    }
+    return *slot;
+}
+
+void setHostRoots(const std::string& procRoot, const std::string& sysRoot) {
+    procRootDir = procRoot.empty() ? "/proc" : procRoot;
+    sysRootDir = sysRoot.empty() ? "/sys" : sysRoot;
+    hostRootsGeneration++;
+    for (auto& entry : sourceRegistry()) {
+        ProcSource& src = *entry.second;
+        if (src.fd >= 0) { close(src.fd); src.fd = -1; }
+        src.path = hostPath(src.key);
+        src.len = 0;
+    }
+}
+
+static bool reopenSource(ProcSource& src) {
+    if (src.fd >= 0) { close(src.fd); countSyscalls(); }
+    src.fd = open(src.path.c_str(), O_RDONLY | O_CLOEXEC);
+    countSyscalls();
+    return src.fd >= 0;
+}
+
+static const ssize_t SeqChunkMin = 4096 - 512; // page minus the longest expected record
+
+// Refreshes src.buf from the kernel. A read error on an already open descriptor
+// (sysfs node removed by hotplug, file recreated, ENOENT) gets one transparent
+// reopen; a missing file is retried on the next call.
+bool readSource(ProcSource& src) {
+    src.len = 0;
+    if (src.fd < 0 && !reopenSource(src)) return false;
+    if (src.buf.empty()) src.buf.resize(4096);
+    bool reopened = false;
+    for (;;) {
+        if (src.len == src.buf.size()) src.buf.resize(src.buf.size() * 2);
+        size_t room = src.buf.size() - src.len;
+        ssize_t n = pread(src.fd, src.buf.data() + src.len, room, src.len);
+        countSyscalls();
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (src.len > 0) return true; // keep what was read
+            if (reopened || !reopenSource(src)) {
+                if (src.fd >= 0) { close(src.fd); src.fd = -1; countSyscalls(); }
+                return false;
+            }
+            reopened = true;
+            continue;
+        }
+        src.len += (size_t)n;
+        // Record-per-line seq files (/proc/net/tcp, diskstats, mounts...) return
+        // at most about a page per read; a short read well below that is EOF.
+        // Continuing at the offset just read is sequential for seq_file, so the
+        // kernel does not re-walk the table.
+        if (n == 0 || ((size_t)n < room && n < SeqChunkMin)) return true;
+    }
+}
+
+// Reads the first integer in a single-value sysfs/procfs file.
+bool readSourceLL(ProcSource& src, long long& value) {
+    if (!readSource(src) || src.len == 0) return false;
+    const char* p = src.begin();
+    value = parseLL(p, src.end());
+    return true;
+}
+
+// The first of several candidate sysfs files that exists, probed once so a
+// collector does not build, hash and re-open every missing path each tick.
+// Probes again when the host roots change.
+class SysfsFirstSource {
+public:
+    SysfsFirstSource(std::initializer_list<const char*> candidates) : candidates(candidates) {}
+
+    ProcSource* get() {
+        if (generation != hostRootsGeneration) {
+            generation = hostRootsGeneration;
+            found = nullptr;
+            for (const char* path : candidates) {
+                ProcSource& src = procSource(path);
+                countSyscalls();
+                if (access(src.path.c_str(), F_OK) == 0) { found = &src; break; }
+            }
+        }
+        return found;
+    }
+
+private:
+    std::vector<const char*> candidates;
+    unsigned generation = ~0u;
+    ProcSource* found = nullptr;
+};
+
+// ==================== SELF PROFILING ====================
+thread_local PerfCounters perfThreadCounters;
+
+// Counting replacement for the global allocator; new[] forwards here in
+// libstdc++. The nothrow form is replaced too, since sanitizer runtimes
+// interpose it and would otherwise see it freed through our operator delete
+// (std::stable_sort's temporary buffer uses it).
+void* operator new(std::size_t size) {
+    perfThreadCounters.allocations++;
+    if (size == 0) size = 1;
+    for (;;) {
+        if (void* p = malloc(size)) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+// noinline keeps GCC from pairing the inlined free() with operator new and
+// reporting a false -Wmismatched-new-delete.
+__attribute__((noinline)) void operator delete(void* p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void* p, std::size_t) noexcept { free(p); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try { return operator new(size); } catch (...) { return nullptr; }
+}
+__attribute__((noinline)) void operator delete(void* p, const std::nothrow_t&) noexcept { free(p); }
+
+static int latencyBucket(long long ns) {
+    if (ns < 4) return ns < 0 ? 0 : (int)ns;
+    int msb = 63 - __builtin_clzll((unsigned long long)ns);
+    int bucket = (msb - 1) * 4 + (int)((ns >> (msb - 2)) & 3);
+    return std::min(bucket, LatencyHistogram::Buckets - 1);
+}
+
+static long long latencyBucketUpper(int bucket) {
+    if (bucket < 4) return bucket;
+    int msb = bucket / 4 + 1;
+    return ((4LL + bucket % 4 + 1) << (msb - 2)) - 1;
+}
+
+void LatencyHistogram::record(long long ns, const PerfCounters& delta) {
+    counts[latencyBucket(ns)]++;
+    samples++;
+    syscalls += delta.syscalls;
+    allocations += delta.allocations;
+    lastNs = ns;
+    if (ns > maxNs) maxNs = ns;
+    totalNs += ns;
+}
+
+long long LatencyHistogram::percentile(double p) const {
+    if (samples == 0) return 0;
+    unsigned long long target = (unsigned long long)(p * samples + 0.999999);
+    if (target == 0) target = 1;
+    unsigned long long seen = 0;
+    for (int b = 0; b < Buckets; b++) {
+        seen += counts[b];
+        if (seen >= target) return std::min(latencyBucketUpper(b), maxNs);
+    }
+    return maxNs;
+}
+
+static const char* const perfNames[PERF_COUNT] = {
+    "readProcStatSnapshot + readSchedStat", "getCPUTemp + getCPUFrequency + loadavg", "getMemoryDetail", "readNetStats",
+    "readDiskStats", "readAllProcTicks", "ProcIoTracker::update", "ProcMemTracker::update", "ProcSchedTracker::update", "getTopProcesses", "CgroupCollector::update", "readSystemPressure", "getUptime",
+    "GpuCollector::poll", "getBatteryInfo", "getDiskPartitions", "getFileDescriptorCount", "getNetworkConnectionCount",
+    "Sampler pass (total)",
+    "Frame: build UI", "Frame: GL draw", "Frame: present",
+};
+
+const char* perfName(PerfId id) {
+    return id >= 0 && id < PERF_COUNT ? perfNames[id] : "?";
+}
+
+// Zero-initialised static storage; recording takes the lock but never allocates.
+static std::mutex perfMutex;
+static LatencyHistogram perfHistograms[PERF_COUNT];
+
+void perfRecord(PerfId id, long long ns, const PerfCounters& delta) {
+    std::lock_guard<std::mutex> lock(perfMutex);
+    perfHistograms[id].record(ns, delta);
+}
+
+void perfSnapshot(std::vector<LatencyHistogram>& out) {
+    out.resize(PERF_COUNT);
+    std::lock_guard<std::mutex> lock(perfMutex);
+    std::copy(perfHistograms, perfHistograms + PERF_COUNT, out.begin());
+}
+
+// ==================== CPU FUNCTIONS ====================
+static const char* parseCPULine(const char* p, const char* end, CPUStats& s) {
+    while (p < end && *p != ' ') p++; // skip "cpu" / "cpuN" label
+    s.user = parseLL(p, end);    s.nice = parseLL(p, end);
+    s.system = parseLL(p, end);  s.idle = parseLL(p, end);
+    s.iowait = parseLL(p, end);  s.irq = parseLL(p, end);
+    s.softirq = parseLL(p, end); s.steal = parseLL(p, end);
+    return skipLine(p, end);
+}
+
+// Parses /proc/stat in one pass. Reuses snap.cores and the cached source buffer,
+// so after the first call a tick performs no heap allocations. The intr line can
+// carry thousands of per-IRQ columns; only its leading total is parsed.
+bool readProcStatSnapshot(ProcStatSnapshot& snap) {
+    static ProcSource& src = procSource("/proc/stat");
+    bool ok = readSource(src);
+    snap.timestamp = monotonicSeconds();
+    snap.total = CPUStats{};
+    snap.ctxt = snap.intr = snap.softirq = 0;
+    snap.procsRunning = snap.procsBlocked = 0;
+    if (!ok) { snap.cores.clear(); return false; }
+
+    const char* p = src.begin();
+    const char* end = src.end();
+    size_t coreCount = 0;
+    while (p < end) {
+        if (startsWith(p, end, "cpu ")) {
+            p = parseCPULine(p, end, snap.total);
+        } else if (startsWith(p, end, "cpu")) {
+            if (coreCount == snap.cores.size()) snap.cores.emplace_back();
+            p = parseCPULine(p, end, snap.cores[coreCount++]);
+        } else if (startsWith(p, end, "ctxt ")) {
+            p += 5; snap.ctxt = parseLL(p, end); p = skipLine(p, end);
+        } else if (startsWith(p, end, "intr ")) {
+            p += 5; snap.intr = parseLL(p, end); p = skipLine(p, end);
+        } else if (startsWith(p, end, "softirq ")) {
+            p += 8; snap.softirq = parseLL(p, end); p = skipLine(p, end);
+        } else if (startsWith(p, end, "procs_running ")) {
+            p += 14; snap.procsRunning = (int)parseLL(p, end); p = skipLine(p, end);
+        } else if (startsWith(p, end, "procs_blocked ")) {
+            p += 14; snap.procsBlocked = (int)parseLL(p, end); p = skipLine(p, end);
+        } else {
+            p = skipLine(p, end);
+        }
+    }
+    snap.cores.resize(coreCount);
+    return true;
+}
+
+CPUStats readCPUStats(const ProcStatSnapshot& snap) {
+    return snap.total;
+}
+
+const std::vector<CPUStats>& readPerCoreCPUStats(const ProcStatSnapshot& snap) {
+    return snap.cores;
+}
+
+float calcCPUUsage(const CPUStats& oldS, const CPUStats& newS) {
+    long long prevIdle = oldS.idle + oldS.iowait;
+    long long idle = newS.idle + newS.iowait;
+    long long prevTotal = prevIdle + oldS.user + oldS.nice + oldS.system + oldS.irq + oldS.softirq + oldS.steal;
+    long long total = idle + newS.user + newS.nice + newS.system + newS.irq + newS.softirq + newS.steal;
+    long long totald = total - prevTotal;
+    long long idled = idle - prevIdle;
+    if (totald <= 0) return 0.0f;
+    return (float)(totald - idled) / (float)totald;
+}
+
+float getCPUTemp() {
+    static SysfsFirstSource sensor({
+        "/sys/class/thermal/thermal_zone0/temp",
+        "/sys/class/hwmon/hwmon0/temp1_input",
+        "/sys/class/hwmon/hwmon1/temp1_input",
+        "/sys/class/hwmon/hwmon2/temp1_input",
+        "/sys/class/hwmon/hwmon3/temp1_input"
+    });
+    ProcSource* src = sensor.get();
+    long long temp;
+    if (!src || !readSourceLL(*src, temp)) return 0.0f;
+    if (temp > 1000) return temp / 1000.0f;
+    return (float)temp;
+}
+
+float getCPUFrequency() {
+    static ProcSource& cur = procSource("/sys/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq");
+    long long freq;
+    if (readSourceLL(cur, freq)) return freq / 1000.0f; // MHz
+
+    static ProcSource& cpuinfo = procSource("/proc/cpuinfo");
+    if (!readSource(cpuinfo)) return 0.0f;
+    const char* end = cpuinfo.end();
+    for (const char* p = cpuinfo.begin(); p < end; p = skipLine(p, end)) {
+        if (!startsWith(p, end, "cpu MHz")) continue;
+        const char* colon = (const char*)memchr(p, ':', end - p);
+        if (!colon) break;
+        colon++;
+        return (float)parseDouble(colon, end);
+    }
+    return 0.0f;
+}
+
+float getCPUMaxFrequency() {
+    std::ifstream file(hostPath("/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_max_freq"));
+    if (file.is_open()) {
+        long long freq;
+        file >> freq;
+        return freq / 1000.0f;
+    }
+    return 0.0f;
+}
+
+int getCPUCoreCount() {
+    std::ifstream file(hostPath("/proc/cpuinfo"));
+    std::string line;
+    int count = 0;
+    while (getline(file, line)) {
+        if (line.find("processor") == 0) count++;
+    }
+    return count > 0 ? count : 1;
+}
+
+int getPhysicalCoreCount() {
+    std::ifstream file(hostPath("/proc/cpuinfo"));
+    std::string line;
+    std::vector<std::string> coreIds;
+    while (getline(file, line)) {
+        if (line.find("core id") != std::string::npos) {
+            size_t pos = line.find(':');
+            if (pos != std::string::npos) {
+                std::string id = line.substr(pos + 1);
+                // trim
+                id.erase(0, id.find_first_not_of(" \t"));
+                id.erase(id.find_last_not_of(" \t") + 1);
+                if (std::find(coreIds.begin(), coreIds.end(), id) == coreIds.end())
+                    coreIds.push_back(id);
+            }
+        }
+    }
+    return coreIds.empty() ? 1 : (int)coreIds.size();
+}
+
+std::string getCPUModel() {
+    std::ifstream file(hostPath("/proc/cpuinfo"));
+    std::string line;
+    while (getline(file, line)) {
+        if (line.find("model name") != std::string::npos) {
+            size_t pos = line.find(':');
+            if (pos != std::string::npos) {
+                std::string model = line.substr(pos + 2);
+                if (model.length() > 40) model = model.substr(0, 37) + "...";
+                return model;
+            }
+        }
+    }
+    return "Unknown CPU";
+}
+
+void getLoadAverages(float& l1, float& l5, float& l15) {
+    static ProcSource& src = procSource("/proc/loadavg");
+    if (!readSource(src)) return;
+    const char* p = src.begin();
+    l1 = (float)parseDouble(p, src.end());
+    l5 = (float)parseDouble(p, src.end());
+    l15 = (float)parseDouble(p, src.end());
+}
+
+// "cpu<N> yld_count 0 sched_count sched_goidle ttwu_count ttwu_local run_ns wait_ns timeslices"
+// since version 15 (Linux 4.x); the sched domain lines in between are skipped.
+bool readSchedStat(std::vector<CpuSchedStat>& out) {
+    static ProcSource& src = procSource("/proc/schedstat");
+    out.clear();
+    if (!readSource(src)) return false;
+    const char* p = src.begin();
+    const char* end = src.end();
+    if (!startsWith(p, end, "version ")) return false;
+    p += 8;
+    if (parseLL(p, end) < 15) return false;
+    for (p = skipLine(p, end); p < end; p = skipLine(p, end)) {
+        if (!startsWith(p, end, "cpu")) continue;
+        p += 3;
+        CpuSchedStat c;
+        c.cpu = (int)parseLL(p, end);
+        for (int i = 0; i < 6; i++) parseLL(p, end);
+        c.runNs = parseLL(p, end);
+        c.waitNs = parseLL(p, end);
+        c.timeslices = parseLL(p, end);
+        out.push_back(c);
+    }
+    return !out.empty();
+}
+
+void getContextSwitchesAndInterrupts(const ProcStatSnapshot& snap, long long& ctxt, long long& intr) {
+    ctxt = snap.ctxt;
+    intr = snap.intr;
+}
+
+// ==================== MEMORY FUNCTIONS ====================
+MemoryDetail getMemoryDetail() {
+    MemoryDetail m = {0};
+    static ProcSource& src = procSource("/proc/meminfo");
+    if (!readSource(src)) return m;
+    const char* end = src.end();
+    for (const char* p = src.begin(); p < end; p = skipLine(p, end)) {
+        const char* colon = (const char*)memchr(p, ':', end - p);
+        if (!colon) break;
+        size_t n = colon - p;
+        const char* v = colon + 1;
+        long long value = parseLL(v, end);
+        auto is = [&](const char* label) { return strlen(label) == n && memcmp(p, label, n) == 0; };
+        if (is("MemTotal"))          m.totalKB = value;
+        else if (is("MemAvailable")) m.availableKB = value;
+        else if (is("MemFree"))      m.freeKB = value;
+        else if (is("Buffers"))      m.buffersKB = value;
+        else if (is("Cached"))       m.cachedKB = value;
+        else if (is("SReclaimable")) m.sreclaimableKB = value;
+        else if (is("Dirty"))        m.dirtyKB = value;
+        else if (is("Writeback"))    m.writebackKB = value;
+        else if (is("SwapTotal"))    m.swapTotalKB = value;
+        else if (is("SwapFree"))     m.swapFreeKB = value;
+        else if (is("SwapCached"))   m.swapCachedKB = value;
+        else if (is("Shmem"))        m.sharedKB = value;
+        else if (is("Active"))       m.activeKB = value;
+        else if (is("Inactive"))     m.inactiveKB = value;
+    }
+    return m;
+}
+
+// ==================== NETLINK ====================
+// A kernel netlink socket kept for the sampler's lifetime (fd -2 = not opened
+// yet, -1 = unavailable). Binary dumps replace parsing large /proc/net tables.
+struct NetlinkChannel {
+    int protocol;
+    int fd = -2;
+    unsigned seq = 0;
+    explicit NetlinkChannel(int protocol) : protocol(protocol) {}
+};
+
+alignas(struct nlmsghdr) static char netlinkBuf[32768];
+
+// Sends one NLM_F_DUMP request (header type plus the family-specific req) and
+// calls onMsg for every reply message. False if the kernel rejected it (e.g. a
+// diag module that is not available) or the dump stalled.
+template <typename OnMsg>
+static bool netlinkDump(NetlinkChannel& ch, unsigned short type, const void* req, size_t reqLen, OnMsg onMsg) {
+    if (ch.fd == -2) {
+        ch.fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, ch.protocol);
+        countSyscalls();
+        if (ch.fd >= 0) {
+            struct timeval timeout = {1, 0};
+            setsockopt(ch.fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            countSyscalls();
+        }
+    }
+    if (ch.fd < 0) return false;
+
+    struct nlmsghdr nh = {};
+    nh.nlmsg_len = NLMSG_LENGTH(reqLen);
+    nh.nlmsg_type = type;
+    nh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    nh.nlmsg_seq = ++ch.seq;
+    struct iovec iov[2] = {{&nh, sizeof(nh)}, {(void*)req, reqLen}};
+    struct sockaddr_nl kernel = {};
+    kernel.nl_family = AF_NETLINK;
+    struct msghdr msg = {};
+    msg.msg_name = &kernel;
+    msg.msg_namelen = sizeof(kernel);
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+    countSyscalls();
+    if (sendmsg(ch.fd, &msg, 0) < 0) return false;
+
+    for (;;) {
+        countSyscalls();
+        ssize_t n = recv(ch.fd, netlinkBuf, sizeof(netlinkBuf), 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        int len = (int)n;
+        for (struct nlmsghdr* h = (struct nlmsghdr*)netlinkBuf; NLMSG_OK(h, len); h = NLMSG_NEXT(h, len)) {
+            if (h->nlmsg_seq != ch.seq) continue; // left over from an aborted dump
+            if (h->nlmsg_type == NLMSG_DONE) return true;
+            if (h->nlmsg_type == NLMSG_ERROR) return false;
+            onMsg(h);
+        }
+    }
+}
+
+// ==================== NETWORK FUNCTIONS ====================
+// Whether name is backed by a device (/sys/class/net/NAME/device).
+static bool hasNetDevice(const std::string& name) {
+    static SysfsNameCache device("/sys/class/net/", "/device");
+    return device.exists(name);
+}
+
+static NetInterfaceStats& nextInterface(std::vector<NetInterfaceStats>& out, size_t& count) {
+    if (count == out.size()) out.emplace_back();
+    return out[count++];
+}
+
+static bool readNetInterfacesNetlink(std::vector<NetInterfaceStats>& out, size_t& count) {
+    static NetlinkChannel route(NETLINK_ROUTE);
+    struct ifinfomsg req = {};
+    req.ifi_family = AF_UNSPEC;
+    return netlinkDump(route, RTM_GETLINK, &req, sizeof(req), [&](const struct nlmsghdr* h) {
+        if (h->nlmsg_type != RTM_NEWLINK) return;
+        const struct ifinfomsg* ifi = (const struct ifinfomsg*)NLMSG_DATA(h);
+        int attrLen = (int)h->nlmsg_len - (int)NLMSG_LENGTH(sizeof(*ifi));
+        const char* name = nullptr;
+        bool haveStats = false, hasKind = false;
+        struct rtnl_link_stats64 stats = {};
+        for (const struct rtattr* a = IFLA_RTA(ifi); RTA_OK(a, attrLen); a = RTA_NEXT(a, attrLen)) {
+            if (a->rta_type == IFLA_IFNAME) {
+                name = (const char*)RTA_DATA(a);
+            } else if (a->rta_type == IFLA_STATS64) {
+                // RTA_DATA is only 4-byte aligned
+                memcpy(&stats, RTA_DATA(a), std::min<size_t>(RTA_PAYLOAD(a), sizeof(stats)));
+                haveStats = true;
+            } else if (a->rta_type == IFLA_LINKINFO) {
+                int infoLen = (int)RTA_PAYLOAD(a);
+                for (const struct rtattr* i = (const struct rtattr*)RTA_DATA(a); RTA_OK(i, infoLen); i = RTA_NEXT(i, infoLen))
+                    if (i->rta_type == IFLA_INFO_KIND) hasKind = true; // veth, bond, vlan, bridge, tun...
+            }
+        }
+        if (!name || !haveStats) return;
+        NetInterfaceStats& n = nextInterface(out, count);
+        n.name.assign(name);
+        n.ifindex = ifi->ifi_index;
+        n.loopback = (ifi->ifi_flags & IFF_LOOPBACK) != 0;
+        n.up = (ifi->ifi_flags & IFF_UP) != 0;
+        n.physical = !n.loopback && !hasKind && hasNetDevice(n.name);
+        n.rxBytes = (long long)stats.rx_bytes;       n.txBytes = (long long)stats.tx_bytes;
+        n.rxPackets = (long long)stats.rx_packets;   n.txPackets = (long long)stats.tx_packets;
+        n.rxDropped = (long long)stats.rx_dropped;   n.txDropped = (long long)stats.tx_dropped;
+        n.rxErrors = (long long)stats.rx_errors;     n.txErrors = (long long)stats.tx_errors;
+    });
+}
+
+static bool readNetInterfacesProc(std::vector<NetInterfaceStats>& out, size_t& count) {
+    static ProcSource& src = procSource("/proc/net/dev");
+    if (!readSource(src)) return false;
+    const char* end = src.end();
+    const char* p = skipLine(skipLine(src.begin(), end), end); // skip headers
+    for (; p < end; p = skipLine(p, end)) {
+        const char* colon = (const char*)memchr(p, ':', end - p);
+        if (!colon) break;
+        const char* name = skipSpaces(p, colon);
+        NetInterfaceStats& n = nextInterface(out, count);
+        n.name.assign(name, colon - name);
+        n.ifindex = 0;
+        n.loopback = n.name == "lo";
+        n.up = true; // not in /proc/net/dev
+        n.physical = !n.loopback && hasNetDevice(n.name);
+        const char* q = colon + 1;
+        // rx: bytes packets errs drop fifo frame compressed multicast, then tx
+        n.rxBytes = parseLL(q, end); n.rxPackets = parseLL(q, end);
+        n.rxErrors = parseLL(q, end); n.rxDropped = parseLL(q, end);
+        for (int i = 0; i < 4; i++) parseLL(q, end);
+        n.txBytes = parseLL(q, end); n.txPackets = parseLL(q, end);
+        n.txErrors = parseLL(q, end); n.txDropped = parseLL(q, end);
+    }
+    return true;
+}
+
+bool readNetInterfaces(std::vector<NetInterfaceStats>& out) {
+    size_t count = 0;
+    // rtnetlink reports the live namespace, which is not what a fixture root shows.
+    bool ok = procRootDir == "/proc" && readNetInterfacesNetlink(out, count);
+    if (!ok) {
+        count = 0;
+        ok = readNetInterfacesProc(out, count);
+    }
+    out.resize(count);
+    return ok;
+}
+
+NetStats sumNetInterfaces(const std::vector<NetInterfaceStats>& ifaces) {
+    NetStats total = {0, 0};
+    bool anyPhysical = std::any_of(ifaces.begin(), ifaces.end(), [](const NetInterfaceStats& n) { return n.physical; });
+    for (const NetInterfaceStats& n : ifaces) {
+        if (anyPhysical ? !n.physical : n.loopback) continue;
+        total.rxBytes += n.rxBytes;
+        total.txBytes += n.txBytes;
+    }
+    return total;
+}
+
+NetStats readNetStats() {
+    static std::vector<NetInterfaceStats> ifaces;
+    readNetInterfaces(ifaces);
+    return sumNetInterfaces(ifaces);
+}
+
+// ==================== SOCKETS ====================
+static const char* const tcpStateNames[SocketStats::TcpStates] = {
+    "UNKNOWN", "ESTABLISHED", "SYN_SENT", "SYN_RECV", "FIN_WAIT1", "FIN_WAIT2",
+    "TIME_WAIT", "CLOSE", "CLOSE_WAIT", "LAST_ACK", "LISTEN", "CLOSING"
+};
+
+const char* tcpStateName(int state) {
+    return state > 0 && state < SocketStats::TcpStates ? tcpStateNames[state] : tcpStateNames[0];
+}
+
+// Dumps are ~90 bytes per socket instead of ~150 of text.
+static NetlinkChannel sockDiag(NETLINK_SOCK_DIAG);
+
+static bool diagCountInet(int family, int protocol, SocketStats& st) {
+    struct inet_diag_req_v2 req = {};
+    req.sdiag_family = family;
+    req.sdiag_protocol = protocol;
+    req.idiag_states = ~0u;
+    return netlinkDump(sockDiag, SOCK_DIAG_BY_FAMILY, &req, sizeof(req), [&](const struct nlmsghdr* h) {
+        const struct inet_diag_msg* m = (const struct inet_diag_msg*)NLMSG_DATA(h);
+        if (protocol == IPPROTO_UDP) { st.udp++; return; }
+        st.tcpTotal++;
+        if (m->idiag_state < SocketStats::TcpStates) st.tcp[m->idiag_state]++;
+    });
+}
+
+static bool diagCountUnix(SocketStats& st) {
+    struct unix_diag_req req = {};
+    req.sdiag_family = AF_UNIX;
+    req.udiag_states = ~0u;
+    return netlinkDump(sockDiag, SOCK_DIAG_BY_FAMILY, &req, sizeof(req), [&](const struct nlmsghdr*) { st.unixSockets++; });
+}
+
+static inline int hexDigit(char c) {
+    return c >= '0' && c <= '9' ? c - '0' : c >= 'A' && c <= 'F' ? c - 'A' + 10 : c >= 'a' && c <= 'f' ? c - 'a' + 10 : 0;
+}
+
+// Rows of a /proc/net/{tcp,udp,unix}* table; with states, also tallies the hex
+// "st" column of the tcp/udp layout.
+static int countProcNetTable(ProcSource& src, int* states) {
+    if (!readSource(src)) return 0;
+    const char* end = src.end();
+    int rows = 0;
+    for (const char* p = skipLine(src.begin(), end); p < end; p = skipLine(p, end)) {
+        rows++;
+        if (!states) continue;
+        const char* q = (const char*)memchr(p, ':', end - p); // after "sl"
+        if (!q) break;
+        q++;
+        for (int field = 0; field < 2; field++) { // local, remote address
+            q = skipSpaces(q, end);
+            while (q < end && *q != ' ') q++;
+        }
+        q = skipSpaces(q, end);
+        if (end - q < 2) break;
+        int state = hexDigit(q[0]) * 16 + hexDigit(q[1]);
+        if (state < SocketStats::TcpStates) states[state]++;
+    }
+    return rows;
+}
+
+static void readSocketSummary(SocketStats& st) {
+    static ProcSource& sockstat = procSource("/proc/net/sockstat");
+    static ProcSource& sockstat6 = procSource("/proc/net/sockstat6");
+    for (ProcSource* src : {&sockstat, &sockstat6}) {
+        if (!readSource(*src)) continue;
+        const char* end = src->end();
+        // "TCP: inuse 5 orphan 0 tw 2 alloc 7 mem 1"
+        for (const char* p = src->begin(); p < end; p = skipLine(p, end)) {
+            bool tcp = startsWith(p, end, "TCP: ") || startsWith(p, end, "TCP6: ");
+            bool udp = startsWith(p, end, "UDP: ") || startsWith(p, end, "UDP6: ");
+            if (!tcp && !udp) continue;
+            const char* q = (const char*)memchr(p, ':', end - p) + 1;
+            const char* eol = skipLine(q, end);
+            while (q < eol) {
+                q = skipSpaces(q, eol);
+                const char* key = q;
+                while (q < eol && *q != ' ' && *q != '\n') q++;
+                std::string_view name(key, q - key);
+                long long value = parseLL(q, eol);
+                if (name == "inuse") (tcp ? st.tcpTotal : st.udp) += (int)value;
+                else if (tcp && name == "tw") st.tcp[SocketStats::TcpTimeWait] += (int)value;
+                if (q < eol && *q == '\n') break;
+            }
+        }
+    }
+    st.tcpTotal += st.tcp[SocketStats::TcpTimeWait]; // inuse excludes TIME_WAIT
+}
+
+SocketStats getSocketStats(bool perState) {
+    SocketStats st = {};
+    st.perState = perState;
+    if (!perState) {
+        st.unixSockets = -1;
+        readSocketSummary(st);
+        return st;
+    }
+
+    // sock_diag reports the live namespace, which is not what a fixture root shows.
+    bool diag = procRootDir == "/proc";
+    if (!diag || !diagCountInet(AF_INET, IPPROTO_TCP, st) || !diagCountInet(AF_INET6, IPPROTO_TCP, st)) {
+        static ProcSource& tcp = procSource("/proc/net/tcp");
+        static ProcSource& tcp6 = procSource("/proc/net/tcp6");
+        std::fill(st.tcp, st.tcp + SocketStats::TcpStates, 0);
+        st.tcpTotal = countProcNetTable(tcp, st.tcp) + countProcNetTable(tcp6, st.tcp);
+    }
+    if (!diag || !diagCountInet(AF_INET, IPPROTO_UDP, st) || !diagCountInet(AF_INET6, IPPROTO_UDP, st)) {
+        static ProcSource& udp = procSource("/proc/net/udp");
+        static ProcSource& udp6 = procSource("/proc/net/udp6");
+        st.udp = countProcNetTable(udp, nullptr) + countProcNetTable(udp6, nullptr);
+    }
+    if (!diag || !diagCountUnix(st)) {
+        static ProcSource& unixTable = procSource("/proc/net/unix");
+        st.unixSockets = countProcNetTable(unixTable, nullptr);
+    }
+    return st;
+}
+
+int getNetworkConnectionCount() {
+    return getSocketStats(false).tcpTotal;
+}
+
+// ==================== DISK FUNCTIONS ====================
+static bool isLoopOrRam(const std::string& name) {
+    return name.compare(0, 4, "loop") == 0 || name.compare(0, 3, "ram") == 0 || name.compare(0, 4, "zram") == 0;
+}
+
+static unsigned classifiedGeneration = ~0u;
+
+bool readBlockDevices(std::vector<BlockDeviceStats>& out) {
+    static ProcSource& src = procSource("/proc/diskstats");
+    static SysfsNameCache sysBlock("/sys/block/", "");
+    static SysfsNameCache blockDevice("/sys/block/", "/device");
+    size_t count = 0;
+    if (!readSource(src)) { out.clear(); return false; }
+    bool haveSysBlock = sysBlock.exists("");
+    const char* end = src.end();
+    for (const char* p = src.begin(); p < end; p = skipLine(p, end)) {
+        const char* eol = skipLine(p, end);
+        parseLL(p, eol); parseLL(p, eol); // major, minor
+        const char* name = p = skipSpaces(p, eol);
+        while (p < eol && *p != ' ' && *p != '\n') p++;
+        const char* nameEnd = p;
+        if (nameEnd == name) continue;
+        // 11 fields, 15 since 4.18 (discard), 17 since 5.5 (flush)
+        long long f[17] = {};
+        for (int i = 0; i < 17; i++) {
+            p = skipSpaces(p, eol);
+            if (p >= eol || *p == '\n') break;
+            f[i] = parseLL(p, eol);
+        }
+
+        if (count == out.size()) out.emplace_back();
+        BlockDeviceStats& d = out[count++];
+        // The device list rarely changes, so the slot usually already holds
+        // this device and its classification.
+        bool known = classifiedGeneration == hostRootsGeneration &&
+                     d.name.size() == (size_t)(nameEnd - name) && memcmp(d.name.data(), name, nameEnd - name) == 0;
+        d.name.assign(name, nameEnd - name);
+        if (!known && haveSysBlock) {
+            d.wholeDisk = sysBlock.exists(d.name);
+            d.physical = d.wholeDisk && blockDevice.exists(d.name);
+        } else if (!known) {
+            // Old rule: sdX/vdX/hdX style three-letter names and NVMe namespaces.
+            bool nvme = d.name.compare(0, 4, "nvme") == 0;
+            d.wholeDisk = !isLoopOrRam(d.name) &&
+                          (d.name.length() == 3 || (nvme && d.name.find('p') == std::string::npos));
+            d.physical = d.wholeDisk;
+        }
+        d.reads = f[0];  d.readsMerged = f[1];  d.sectorsRead = f[2];    d.readTicks = f[3];
+        d.writes = f[4]; d.writesMerged = f[5]; d.sectorsWritten = f[6]; d.writeTicks = f[7];
+        d.inFlight = f[8]; d.ioTicks = f[9]; d.timeInQueue = f[10];
+        d.discards = f[11]; d.discardsMerged = f[12]; d.sectorsDiscarded = f[13]; d.discardTicks = f[14];
+        d.flushes = f[15]; d.flushTicks = f[16];
+    }
+    out.resize(count);
+    classifiedGeneration = hostRootsGeneration;
+    return true;
+}
+
+DiskStats sumBlockDevices(const std::vector<BlockDeviceStats>& devices) {
+    DiskStats total = {0, 0};
+    for (const BlockDeviceStats& d : devices) {
+        if (!d.physical) continue;
+        total.readBytes += d.sectorsRead * 512; // diskstats sectors are always 512 bytes
+        total.writeBytes += d.sectorsWritten * 512;
+    }
+    return total;
+}
+
+DiskStats readDiskStats() {
+    static std::vector<BlockDeviceStats> devices;
+    readBlockDevices(devices);
+    return sumBlockDevices(devices);
+}
+
+// ==================== FILESYSTEM USAGE ====================
+struct FsUsageCollector::Shared {
+    struct Entry {
+        bool inFlight = false; // queued or running
+        bool running = false;  // a worker is inside statvfs()
+        bool valid = false;    // st holds a successful answer
+        bool suspect = false;  // the last answer took longer than Timeout
+        double startedAt = 0;  // when the running call started
+        struct statvfs st;
+    };
+    std::mutex mutex;
+    std::condition_variable work, done;
+    std::deque<std::string> queue;                  // mount points waiting for a worker
+    std::unordered_map<std::string, Entry> entries; // by mount point
+    int workers = 0, busy = 0;
+    bool stopping = false;
+};
+
+FsUsageCollector::~FsUsageCollector() {
+    if (!shared) return;
+    // Workers are detached: idle ones exit now, stuck ones once statvfs() returns.
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    shared->stopping = true;
+    shared->queue.clear();
+    shared->work.notify_all();
+}
+
+void FsUsageCollector::workerLoop(std::shared_ptr<Shared> s) {
+    std::unique_lock<std::mutex> lock(s->mutex);
+    for (;;) {
+        s->work.wait(lock, [&] { return s->stopping || !s->queue.empty(); });
+        if (s->stopping) break;
+        std::string path = std::move(s->queue.front());
+        s->queue.pop_front();
+        s->busy++;
+        // The timeout runs from here, not from queueing, so mounts waiting
+        // behind a slow one are not reported unresponsive.
+        double startedAt = monotonicSeconds();
+        {
+            Shared::Entry& e = s->entries[path];
+            e.running = true;
+            e.startedAt = startedAt;
+        }
+        lock.unlock();
+        struct statvfs st;
+        countSyscalls();
+        bool ok = statvfs(path.c_str(), &st) == 0;
+        double took = monotonicSeconds() - startedAt;
+        lock.lock();
+        s->busy--;
+        Shared::Entry& e = s->entries[path];
+        e.inFlight = e.running = false;
+        e.suspect = took >= Timeout;
+        e.valid = ok;
+        if (ok) e.st = st;
+        s->done.notify_all();
+        // Replacements for stuck workers retire once the pool is back to size.
+        if (s->workers > MaxWorkers && s->queue.empty()) break;
+    }
+    s->workers--;
+}
+
+// Mount points in mountinfo escape space, tab, newline and backslash as \ooo.
+static void unescapeMountPath(std::string& path) {
+    size_t out = 0;
+    for (size_t i = 0; i < path.size(); i++) {
+        if (path[i] == '\\' && i + 3 < path.size() && path[i + 1] >= '0' && path[i + 1] <= '3') {
+            path[out++] = (char)(((path[i + 1] - '0') << 6) | ((path[i + 2] - '0') << 3) | (path[i + 3] - '0'));
+            i += 3;
+        } else {
+            path[out++] = path[i];
+        }
+    }
+    path.resize(out);
+}
+
+static bool showFilesystem(const std::string& fsType, const std::string& mountPoint) {
+    auto startsWith = [](const std::string& s, const char* lit) {
+        return s.compare(0, strlen(lit), lit) == 0;
+    };
+    // Container runtimes mount an overlay (and often tmpfs/nfs volumes) per
+    // container under their state directories; those belong to the containers.
+    if (startsWith(mountPoint, "/var/lib/docker/") || startsWith(mountPoint, "/var/lib/containers/") ||
+        startsWith(mountPoint, "/var/lib/containerd/") || startsWith(mountPoint, "/run/containerd/") ||
+        startsWith(mountPoint, "/var/lib/kubelet/"))
+        return false;
+    if (fsType == "tmpfs") return mountPoint == "/tmp"; // only show /tmp for tmpfs
+    if (fsType == "fuse" || fsType == "fuseblk" || startsWith(fsType, "fuse.")) return true;
+    static const char* const types[] = {
+        "ext2", "ext3", "ext4", "btrfs", "xfs", "zfs", "bcachefs", "ntfs", "ntfs3", "vfat", "exfat", "f2fs",
+        "overlay", "nfs", "nfs4", "cifs", "smb3",
+    };
+    for (const char* type : types)
+        if (fsType == type) return true;
+    return false;
+}
+
+void FsUsageCollector::refreshMounts() {
+    static ProcSource& mountinfo = procSource("/proc/self/mountinfo");
+    // procfs flags POLLPRI (with POLLERR) once the namespace's mount table changed
+    // since this fd last read it.
+    if (mountsGeneration == hostRootsGeneration && mountinfo.fd >= 0) {
+        struct pollfd pfd = {mountinfo.fd, POLLPRI, 0};
+        countSyscalls();
+        if (poll(&pfd, 1, 0) <= 0 || !(pfd.revents & (POLLPRI | POLLERR))) return;
+    }
+    mountsGeneration = hostRootsGeneration;
+    mounts.clear();
+    if (!readSource(mountinfo)) return;
+
+    // "36 35 98:0 /mnt1 /mnt/parent rw,noatime master:1 - ext3 /dev/root rw"
+    std::vector<std::string> devices; // bind mounts repeat a device; keep its first mount
+    const char* end = mountinfo.end();
+    for (const char* p = mountinfo.begin(); p < end; p = skipLine(p, end)) {
+        auto field = [&]() {
+            const char* start = p = skipSpaces(p, end);
+            while (p < end && *p != ' ' && *p != '\n') p++;
+            return std::string_view(start, p - start);
+        };
+        field(); // mount id
+        field(); // parent id
+        std::string_view device = field();
+        field(); // root within the filesystem
+        std::string_view mountPoint = field();
+        field(); // mount options
+        std::string_view tag;
+        while (!(tag = field()).empty() && tag != "-") {} // optional fields end at "-"
+        if (tag.empty()) continue;
+        std::string_view fsType = field();
+
+        Mount m;
+        m.fsType.assign(fsType.data(), fsType.size());
+        m.mountPoint.assign(mountPoint.data(), mountPoint.size());
+        unescapeMountPath(m.mountPoint);
+        if (!showFilesystem(m.fsType, m.mountPoint)) continue;
+        std::string dev(device);
+        if (std::find(devices.begin(), devices.end(), dev) != devices.end()) continue;
+        devices.push_back(std::move(dev));
+        mounts.push_back(std::move(m));
+    }
+
+    if (shared) {
+        // Forget unmounted filesystems, except calls still in flight.
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        for (auto it = shared->entries.begin(); it != shared->entries.end();) {
+            bool mounted = std::any_of(mounts.begin(), mounts.end(),
+                                       [&](const Mount& m) { return m.mountPoint == it->first; });
+            it = mounted || it->second.inFlight ? std::next(it) : shared->entries.erase(it);
+        }
+    }
+}
+
+void FsUsageCollector::collect(std::vector<DiskInfo>& out) {
+    refreshMounts();
+    if (!shared) shared = std::make_shared<Shared>();
+    Shared& s = *shared;
+    double now = monotonicSeconds();
+
+    std::unique_lock<std::mutex> lock(s.mutex);
+    // Mounts that were slow last time queue behind the others, and a call still
+    // stuck from an earlier round is not queued again.
+    for (int suspects = 0; suspects < 2; suspects++) {
+        for (const Mount& m : mounts) {
+            Shared::Entry& e = s.entries[m.mountPoint];
+            if (e.inFlight || e.suspect != (suspects == 1)) continue;
+            e.inFlight = true;
+            s.queue.push_back(m.mountPoint);
+        }
+    }
+    auto timedOut = [&](const Shared::Entry& e) { return e.running && now - e.startedAt >= Timeout; };
+    // Workers stuck past Timeout do not count against the pool (up to
+    // MaxStuckWorkers of them), so dead mounts cannot starve healthy ones.
+    int stuck = 0;
+    for (const auto& entry : s.entries)
+        if (timedOut(entry.second)) stuck++;
+    int limit = MaxWorkers + std::min(stuck, (int)MaxStuckWorkers);
+    while (s.workers < limit && s.workers - s.busy < (int)s.queue.size()) {
+        std::thread(workerLoop, shared).detach();
+        s.workers++;
+    }
+    s.work.notify_all();
+
+    auto answered = [&] {
+        for (const Mount& m : mounts) {
+            const Shared::Entry& e = s.entries[m.mountPoint];
+            if (e.inFlight && !timedOut(e)) return false;
+        }
+        return true;
+    };
+    s.done.wait_for(lock, std::chrono::duration<double>(WaitBudget), answered);
+
+    now = monotonicSeconds();
+    out.clear();
+    for (const Mount& m : mounts) {
+        const Shared::Entry& e = s.entries[m.mountPoint];
+        DiskInfo info;
+        info.name = m.mountPoint;
+        info.fsType = m.fsType;
+        if (info.name.length() > 18) info.name = "..." + info.name.substr(info.name.length() - 15);
+        info.unresponsive = timedOut(e);
+        info.totalGB = info.usedGB = info.usagePercent = 0;
+        if (e.valid) {
+            info.totalGB = (e.st.f_blocks * e.st.f_frsize) / (1024.0 * 1024.0 * 1024.0);
+            float freeGB = (e.st.f_bfree * e.st.f_frsize) / (1024.0 * 1024.0 * 1024.0);
+            info.usedGB = info.totalGB - freeGB;
+            info.usagePercent = (info.totalGB > 0) ? (info.usedGB / info.totalGB) : 0;
+        }
+        if (info.totalGB > 0.1 || info.unresponsive) out.push_back(info);
+    }
+}
+
+// ==================== GPU FUNCTIONS ====================
+static std::string nvidiaSmiCommand = "nvidia-smi";
+
+void setNvidiaSmiCommand(const std::string& command) {
+    nvidiaSmiCommand = command.empty() ? "nvidia-smi" : command;
+}
+
+// AMD (hwmon temperature + busy percent) or Intel (PCI vendor id) on card0.
+static bool readSysfsGpu(GPUInfo& gpu) {
+    gpu = GPUInfo{"", 0, 0, 0, 0, 0, 0, false, 0};
+    static SysfsFirstSource amdTemp({
+        "/sys/class/drm/card0/device/hwmon/hwmon0/temp1_input",
+        "/sys/class/drm/card0/device/hwmon/hwmon1/temp1_input",
+        "/sys/class/drm/card1/device/hwmon/hwmon0/temp1_input"
+    });
+    static SysfsFirstSource amdBusy({"/sys/class/drm/card0/device/gpu_busy_percent"});
+    static SysfsFirstSource vendorId({"/sys/class/drm/card0/device/vendor"});
+    long long t;
+    if (ProcSource* temp = amdTemp.get()) {
+        if (readSourceLL(*temp, t)) {
+            gpu.temp = (int)(t / 1000);
+            gpu.name = "AMD GPU";
+            gpu.available = true;
+            // try to get usage
+            long long busy;
+            ProcSource* usage = amdBusy.get();
+            if (usage && readSourceLL(*usage, busy)) gpu.usagePercent = (int)busy;
+            return true;
+        }
+    }
+
+    ProcSource* vendor = vendorId.get();
+    if (vendor && readSource(*vendor) && startsWith(vendor->begin(), vendor->end(), "0x8086")) {
+        gpu.name = "Intel iGPU";
+        gpu.available = true;
+        return true;
+    }
+    return false;
+}
+
+GpuCollector::~GpuCollector() {
+    if (child > 0) kill(child, SIGTERM);
+    reap();
+}
+
+bool GpuCollector::spawn() {
+    int fds[2];
+    countSyscalls();
+    if (pipe2(fds, O_CLOEXEC) != 0) return false;
+    fcntl(fds[0], F_SETFL, O_NONBLOCK); // the child's end stays blocking
+
+    char loop[32];
+    snprintf(loop, sizeof(loop), "--loop-ms=%d", periodMs);
+    const char* argv[] = {
+        nvidiaSmiCommand.c_str(),
+        "--query-gpu=index,name,temperature.gpu,utilization.gpu,memory.used,memory.total,fan.speed,power.draw",
+        "--format=csv,noheader,nounits", loop, NULL
+    };
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+    // The daemon blocks SIGINT/SIGTERM and ignores SIGPIPE; neither may leak into
+    // the child, or it would outlive us.
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t none, defaults;
+    sigemptyset(&none);
+    sigemptyset(&defaults);
+    for (int sig : {SIGINT, SIGTERM, SIGPIPE}) sigaddset(&defaults, sig);
+    posix_spawnattr_setsigmask(&attr, &none);
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+    int rc = posix_spawnp(&child, argv[0], &actions, &attr, const_cast<char* const*>(argv), environ);
+    countSyscalls();
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    close(fds[1]);
+    if (rc != 0) {
+        child = -1;
+        close(fds[0]);
+        return false;
+    }
+    fd = fds[0];
+    pending.clear();
+    return true;
+}
+
+// Closes the pipe and collects the child. A stream that never produced a line
+// (no binary, no driver, no GPU) is not retried.
+void GpuCollector::reap() {
+    if (fd >= 0) { close(fd); fd = -1; }
+    if (child > 0) {
+        if (waitpid(child, NULL, WNOHANG) == 0) {
+            kill(child, SIGTERM);
+            waitpid(child, NULL, 0);
+        }
+        child = -1;
+    }
+    if (!producedData) disabled = true;
+    restartAt = monotonicSeconds() + RestartDelay;
+    latest.clear();
+    rawNames.clear();
+}
+
+// "0, NVIDIA GeForce RTX 3080, 45, 12, 1024, 10240, 30, 120.50"; unsupported
+// values are printed as "[N/A]" or "[Not Supported]".
+void GpuCollector::parseLine(const char* p, const char* end) {
+    const char* fields[8][2];
+    int n = 0;
+    while (n < 8) {
+        const char* comma = (const char*)memchr(p, ',', end - p);
+        const char* fieldEnd = comma ? comma : end;
+        const char* start = skipSpaces(p, fieldEnd);
+        const char* stop = fieldEnd;
+        while (stop > start && (stop[-1] == ' ' || stop[-1] == '\r')) stop--;
+        fields[n][0] = start;
+        fields[n][1] = stop;
+        n++;
+        if (!comma) break;
+        p = comma + 1;
+    }
+    if (n < 8) return;
+    auto number = [&](int i, int missing) {
+        const char* q = fields[i][0];
+        if (q >= fields[i][1] || !(*q == '-' || (*q >= '0' && *q <= '9'))) return missing;
+        return (int)parseDouble(q, fields[i][1]);
+    };
+    int index = number(0, -1);
+    if (index < 0 || index > 255) return;
+    if ((int)latest.size() <= index) {
+        latest.resize(index + 1, GPUInfo{"", 0, 0, 0, 0, 0, 0, false, 0});
+        rawNames.resize(index + 1);
+    }
+    GPUInfo& gpu = latest[index];
+    gpu.index = index;
+    std::string& raw = rawNames[index];
+    if (raw.size() != (size_t)(fields[1][1] - fields[1][0]) ||
+        memcmp(raw.data(), fields[1][0], raw.size()) != 0) {
+        raw.assign(fields[1][0], fields[1][1]);
+        gpu.name = raw.length() > 28 ? raw.substr(0, 25) + "..." : raw;
+    }
+    gpu.temp = number(2, 0);
+    gpu.usagePercent = number(3, -1);
+    gpu.memUsedMB = number(4, 0);
+    gpu.memTotalMB = number(5, 0);
+    gpu.fanSpeed = number(6, 0);
+    gpu.powerDraw = number(7, 0);
+    gpu.available = true;
+    producedData = true;
+}
+
+void GpuCollector::poll(std::vector<GPUInfo>& gpus) {
+    if (fd < 0 && !disabled && monotonicSeconds() >= restartAt && !spawn()) disabled = true;
+
+    if (fd >= 0) {
+        char buf[4096];
+        bool exited = false;
+        for (;;) {
+            ssize_t n = read(fd, buf, sizeof(buf));
+            countSyscalls();
+            if (n > 0) { pending.append(buf, n); continue; }
+            if (n < 0 && errno == EINTR) continue;
+            exited = n == 0;
+            break;
+        }
+        size_t consumed = 0;
+        for (;;) {
+            size_t nl = pending.find('\n', consumed);
+            if (nl == std::string::npos) break;
+            parseLine(pending.data() + consumed, pending.data() + nl);
+            consumed = nl + 1;
+        }
+        pending.erase(0, consumed);
+        if (pending.size() > 65536) pending.clear(); // not line-oriented output
+        if (exited) reap();
+    }
+
+    gpus.clear();
+    for (const GPUInfo& gpu : latest)
+        if (gpu.available) gpus.push_back(gpu);
+    if (gpus.empty() && fd < 0) {
+        GPUInfo gpu;
+        if (readSysfsGpu(gpu)) gpus.push_back(gpu);
+    }
+}
+
+void GpuCollector::setInterval(int ms) {
+    if (ms == periodMs) return;
+    periodMs = ms;
+    if (child <= 0) return;
+    // Not reap(): a deliberate restart neither disables the stream nor waits
+    // out RestartDelay, and the last readings stay until the new child reports.
+    close(fd);
+    fd = -1;
+    kill(child, SIGTERM);
+    waitpid(child, NULL, 0);
+    countSyscalls(3);
+    child = -1;
+    restartAt = 0;
+}
+
+// ==================== BATTERY FUNCTIONS ====================
+struct BatterySources {
+    ProcSource *capacity, *status, *powerNow, *energyNow, *energyFull;
+};
+
+static BatterySources batterySources(const char* base) {
+    std::string b(base);
+    return { &procSource(b + "/capacity"), &procSource(b + "/status"), &procSource(b + "/power_now"),
+             &procSource(b + "/energy_now"), &procSource(b + "/energy_full") };
+}
+
+BatteryInfo getBatteryInfo() {
+    BatteryInfo bat = {0, false, false, 0, 0};
+    static const BatterySources bases[] = {
+        batterySources("/sys/class/power_supply/BAT0"),
+        batterySources("/sys/class/power_supply/BAT1")
+    };
+    for (const BatterySources& b : bases) {
+        long long capacity;
+        if (readSourceLL(*b.capacity, capacity)) {
+            bat.percent = (int)capacity;
+            bat.available = true;
+
+            if (readSource(*b.status)) {
+                std::string_view status(b.status->begin(), b.status->len);
+                bat.charging = status.rfind("Charging", 0) == 0 || status.rfind("Full", 0) == 0;
+            }
+
+            long long power;
+            if (readSourceLL(*b.powerNow, power))
+                bat.powerWatts = power / 1000000.0f;
+
+            // estimated time
+            long long eNow, eFull;
+            if (bat.powerWatts > 0.1f && readSourceLL(*b.energyNow, eNow) && readSourceLL(*b.energyFull, eFull)) {
+                if (!bat.charging)
+                    bat.estimatedMinutes = (int)((eNow / 1000000.0f) / bat.powerWatts * 60);
+                else
+                    bat.estimatedMinutes = (int)(((eFull - eNow) / 1000000.0f) / bat.powerWatts * 60);
+            }
+            break;
+        }
+    }
+    return bat;
+}
+
+// ==================== PROCESS FUNCTIONS ====================
+// Parses one /proc/[pid]/stat line. comm may contain spaces and parentheses, so
+// the numeric fields start after the *last* ')'.
+static bool parseProcStat(const char* buf, size_t len, ProcRecord& r) {
+    const char* end = buf + len;
+    const char* lp = (const char*)memchr(buf, '(', len);
+    const char* rp = (const char*)memrchr(buf, ')', len);
+    if (!lp || !rp || rp < lp || rp + 2 >= end) return false;
+
+    size_t n = std::min((size_t)(rp - lp - 1), sizeof(r.comm) - 1);
+    memcpy(r.comm, lp + 1, n);
+    r.comm[n] = 0;
+
+    const char* p = rp + 2;
+    r.state = *p++;
+    // Field numbers follow proc(5); state is field 3.
+    for (int field = 4; field <= 39 && p < end; field++) {
+        long long v = parseLL(p, end);
+        switch (field) {
+            case 4:  r.ppid = (int)v; break;
+            case 10: r.minflt = v; break;
+            case 12: r.majflt = v; break;
+            case 14: r.utime = v; break;
+            case 15: r.stime = v; break;
+            case 20: r.numThreads = (int)v; break;
+            case 22: r.starttime = v; break;
+            case 24: r.rss = v; break;
+            case 39: r.processor = (int)v; break;
+        }
+    }
+    return true;
+}
+
+// Reads and parses <dfd>/<pid>/stat. False if the process exited since readdir.
+static bool readProcRecord(int dfd, int pid, char* buf, size_t bufSize, ProcRecord& r) {
+    char path[32];
+    snprintf(path, sizeof(path), "%d/stat", pid);
+    int fd = openat(dfd, path, O_RDONLY | O_CLOEXEC);
+    countSyscalls();
+    if (fd < 0) return false;
+    ssize_t len = read(fd, buf, bufSize);
+    close(fd);
+    countSyscalls(2);
+    if (len <= 0) return false;
+
+    r = ProcRecord{};
+    r.pid = pid;
+    return parseProcStat(buf, (size_t)len, r);
+}
+
+// The single per-tick /proc walk: one open/read/close of /proc/[pid]/stat per
+// process. Everything else about processes (CPU deltas, top list, process and
+// thread totals) is derived from these records. records keeps its capacity.
+void readAllProcTicks(std::vector<ProcRecord>& records) {
+    records.clear();
+    DIR* dir = opendir(procRootDir.c_str());
+    countSyscalls();
+    if (!dir) return;
+    int dfd = dirfd(dir);
+    char buf[2048];
+    struct dirent* entry;
+    // readdir's batched getdents64 calls (a handful per walk) are not counted.
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_type != DT_DIR) continue;
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+        ProcRecord r;
+        if (readProcRecord(dfd, atoi(entry->d_name), buf, sizeof(buf), r)) records.push_back(r);
+    }
+    closedir(dir);
+    countSyscalls();
+}
+
+ProcWalker::ProcWalker(int threads) {
+    int n = std::max(1, threads);
+    slices.resize(n);
+    for (int i = 1; i < n; i++) workers.emplace_back(&ProcWalker::workerLoop, this, i);
+}
+
+ProcWalker::~ProcWalker() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    startWork.notify_all();
+    for (std::thread& t : workers) t.join();
+}
+
+void ProcWalker::readSlice(Slice& slice) {
+    slice.records.clear();
+    unsigned long long before = perfThreadCounters.syscalls;
+    char buf[2048];
+    ProcRecord r;
+    for (size_t i = slice.begin; i < slice.end; i++)
+        if (readProcRecord(dirFd, (*slicePids)[i], buf, sizeof(buf), r)) slice.records.push_back(r);
+    slice.syscalls = perfThreadCounters.syscalls - before;
+}
+
+void ProcWalker::workerLoop(int index) {
+    unsigned long long seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            startWork.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+        readSlice(slices[index]);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pending == 0) workDone.notify_one();
+        }
+    }
+}
+
+// Numeric entries of the proc root, in readdir order.
+bool listProcPids(std::vector<int>& pids) {
+    pids.clear();
+    DIR* dir = opendir(procRootDir.c_str());
+    countSyscalls();
+    if (!dir) return false;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_type != DT_DIR) continue;
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+        pids.push_back(atoi(entry->d_name));
+    }
+    closedir(dir);
+    countSyscalls();
+    return true;
+}
+
+void ProcWalker::walk(std::vector<ProcRecord>& records) {
+    if (workers.empty()) { readAllProcTicks(records); return; }
+    records.clear();
+    if (listProcPids(pids)) read(pids, records);
+}
+
+void ProcWalker::read(const std::vector<int>& pidList, std::vector<ProcRecord>& records) {
+    records.clear();
+    dirFd = open(procRootDir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    countSyscalls();
+    if (dirFd < 0) return;
+    slicePids = &pidList;
+
+    // Contiguous slices in list order; below the threshold the wake-up cost
+    // outweighs the parallelism, so only this thread's slice is used.
+    size_t count = pidList.size();
+    size_t active = count < ParallelThreshold ? 1 : slices.size();
+    size_t per = (count + active - 1) / active;
+    for (size_t i = 0; i < slices.size(); i++) {
+        slices[i].begin = std::min(count, i * per);
+        slices[i].end = i < active ? std::min(count, (i + 1) * per) : slices[i].begin;
+    }
+
+    if (active > 1) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending = (int)workers.size();
+            generation++;
+        }
+        startWork.notify_all();
+    }
+    readSlice(slices[0]);
+    if (active > 1) {
+        std::unique_lock<std::mutex> lock(mutex);
+        workDone.wait(lock, [&] { return pending == 0; });
+    }
+    close(dirFd);
+    dirFd = -1;
+    countSyscalls();
+
+    // Merge in slice order: same records, same order as a serial read. Slices
+    // past active were not read this call and still hold an earlier walk.
+    size_t total = 0;
+    for (size_t i = 0; i < active; i++) total += slices[i].records.size();
+    records.reserve(total);
+    for (size_t i = 0; i < active; i++) {
+        records.insert(records.end(), slices[i].records.begin(), slices[i].records.end());
+        if (i > 0) countSyscalls((int)slices[i].syscalls);
+    }
+}
+
+// Sends a PROC_CN_MCAST_LISTEN / _IGNORE request to the proc connector.
+static bool sendProcConnectorOp(int sock, int op) {
+    alignas(struct nlmsghdr) char msg[NLMSG_SPACE(sizeof(struct cn_msg) + sizeof(int))] = {};
+    struct nlmsghdr* nh = (struct nlmsghdr*)msg;
+    nh->nlmsg_len = NLMSG_LENGTH(sizeof(struct cn_msg) + sizeof(int));
+    nh->nlmsg_type = NLMSG_DONE;
+    nh->nlmsg_pid = getpid();
+    struct cn_msg* cn = (struct cn_msg*)NLMSG_DATA(nh);
+    cn->id.idx = CN_IDX_PROC;
+    cn->id.val = CN_VAL_PROC;
+    cn->len = sizeof(int);
+    memcpy(cn->data, &op, sizeof(int));
+    countSyscalls();
+    return send(sock, msg, nh->nlmsg_len, 0) == (ssize_t)nh->nlmsg_len;
+}
+
+ProcEventTracker::~ProcEventTracker() {
+    if (sock < 0) return;
+    sendProcConnectorOp(sock, PROC_CN_MCAST_IGNORE);
+    close(sock);
+}
+
+bool ProcEventTracker::open() {
+    if (sock >= 0) return true;
+    if (procRootDir != "/proc") return false;
+    sock = socket(PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+    countSyscalls();
+    if (sock < 0) return false;
+
+    struct sockaddr_nl addr = {};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = CN_IDX_PROC;
+    countSyscalls();
+    bool ok = bind(sock, (struct sockaddr*)&addr, sizeof(addr)) == 0 &&
+              sendProcConnectorOp(sock, PROC_CN_MCAST_LISTEN);
+
+    // The kernel answers the listen request with an ack carrying the error
+    // (EPERM without CAP_NET_ADMIN on older kernels); events that arrive first
+    // are kept.
+    acked = false;
+    ackError = 0;
+    double deadline = monotonicSeconds() + 0.25;
+    while (ok && !acked) {
+        int remainingMs = (int)((deadline - monotonicSeconds()) * 1000);
+        if (remainingMs <= 0) break;
+        struct pollfd pfd = {sock, POLLIN, 0};
+        countSyscalls();
+        if (poll(&pfd, 1, remainingMs) <= 0) break;
+        drain();
+    }
+    if (!ok || !acked || ackError != 0) {
+        close(sock);
+        sock = -1;
+        born.clear();
+        return false;
+    }
+
+    // Subscribed before listing, so every process born after the listing is
+    // covered by an event; births already queued are merged on top.
+    listProcPids(pids);
+    std::sort(pids.begin(), pids.end());
+    needResync = false;
+    return true;
+}
+
+void ProcEventTracker::drain() {
+    alignas(struct nlmsghdr) char buf[16384];
+    for (;;) {
+        struct sockaddr_nl from = {};
+        socklen_t fromLen = sizeof(from);
+        countSyscalls();
+        ssize_t n = recvfrom(sock, buf, sizeof(buf), 0, (struct sockaddr*)&from, &fromLen);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == ENOBUFS) { needResync = true; continue; } // events were dropped
+            break; // EAGAIN: queue empty
+        }
+        if (n == 0) break;
+        if (from.nl_pid != 0) continue; // only the kernel may speak for the connector
+
+        int len = (int)n;
+        for (struct nlmsghdr* nh = (struct nlmsghdr*)buf; NLMSG_OK(nh, len); nh = NLMSG_NEXT(nh, len)) {
+            if (nh->nlmsg_type == NLMSG_NOOP || nh->nlmsg_type == NLMSG_ERROR) continue;
+            struct cn_msg* cn = (struct cn_msg*)NLMSG_DATA(nh);
+            if (cn->id.idx != CN_IDX_PROC || cn->id.val != CN_VAL_PROC) continue;
+            // cn->data is only 4-byte aligned; copy the event out.
+            struct proc_event event = {};
+            memcpy(&event, cn->data, std::min<size_t>(cn->len, sizeof(event)));
+            const struct proc_event* ev = &event;
+            switch (ev->what) {
+            case proc_event::PROC_EVENT_NONE:
+                acked = true;
+                ackError = ev->event_data.ack.err;
+                break;
+            case proc_event::PROC_EVENT_FORK:
+                // New threads also fork; only a new thread group is a new process.
+                if (ev->event_data.fork.child_pid == ev->event_data.fork.child_tgid)
+                    born.push_back(ev->event_data.fork.child_tgid);
+                break;
+            case proc_event::PROC_EVENT_EXEC:
+                // Also covers a process whose fork predates the subscription.
+                born.push_back(ev->event_data.exec.process_tgid);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    if (born.size() > MaxPendingBirths) needResync = true;
+}
+
+const std::vector<int>& ProcEventTracker::update() {
+    if (sock < 0) return pids;
+    drain();
+    if (needResync) {
+        born.clear();
+        needResync = false;
+        resyncs++;
+        listProcPids(pids);
+        std::sort(pids.begin(), pids.end());
+        return pids;
+    }
+    if (born.empty()) return pids;
+
+    // A reused pid may already be in the set; set_union keeps one copy.
+    std::sort(born.begin(), born.end());
+    merged.clear();
+    std::set_union(pids.begin(), pids.end(), born.begin(), born.end(), std::back_inserter(merged));
+    merged.erase(std::unique(merged.begin(), merged.end()), merged.end());
+    pids.swap(merged);
+    born.clear();
+    return pids;
+}
+
+void ProcEventTracker::retain(const std::vector<ProcRecord>& records) {
+    if (records.size() == pids.size()) return; // every pid was read
+    pids.clear();
+    for (const ProcRecord& r : records) pids.push_back(r.pid);
+}
+
+ProcIoTracker::~ProcIoTracker() {
+    if (dirFd >= 0) close(dirFd);
+}
+
+// A tracker's cached fd for <proc root>, reopened when the host roots change.
+static bool openProcDir(int& dirFd, unsigned& dirGeneration) {
+    if (dirFd < 0 || dirGeneration != hostRootsGeneration) {
+        if (dirFd >= 0) { close(dirFd); countSyscalls(); }
+        dirFd = open(procRootDir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        countSyscalls();
+        dirGeneration = hostRootsGeneration;
+    }
+    return dirFd >= 0;
+}
+
+// Reads <proc root>/<pid>/<name> into buf through the cached directory fd.
+// Returns the length, or -1 with errno set (EACCES for files that need ptrace
+// access to someone else's process).
+static ssize_t readPidFile(int& dirFd, unsigned& dirGeneration, int pid, const char* name, char* buf, size_t bufSize) {
+    if (!openProcDir(dirFd, dirGeneration)) return -1;
+    char path[48];
+    snprintf(path, sizeof(path), "%d/%s", pid, name);
+    int fd = openat(dirFd, path, O_RDONLY | O_CLOEXEC);
+    countSyscalls();
+    if (fd < 0) return -1;
+    ssize_t len = read(fd, buf, bufSize);
+    int readErrno = errno;
+    close(fd);
+    countSyscalls(2);
+    errno = readErrno;
+    return len;
+}
+
+// Parses <proc root>/<pid>/io. Needs ptrace read access to the process, so this
+// fails for other users' processes unless we run as root.
+bool ProcIoTracker::readCounters(int pid, Counters& c) {
+    char buf[512];
+    ssize_t len = readPidFile(dirFd, dirGeneration, pid, "io", buf, sizeof(buf));
+    if (len <= 0) return false;
+
+    // "rchar: N\nwchar: N\nsyscr: N\nsyscw: N\nread_bytes: N\nwrite_bytes: N\ncancelled_write_bytes: N\n"
+    c = Counters{};
+    int found = 0;
+    const char* end = buf + len;
+    for (const char* p = buf; p < end; p = skipLine(p, end)) {
+        const char* colon = (const char*)memchr(p, ':', end - p);
+        if (!colon) break;
+        std::string_view key(p, colon - p);
+        const char* v = colon + 1;
+        long long* field = key == "read_bytes" ? &c.readBytes
+                         : key == "write_bytes" ? &c.writeBytes
+                         : key == "cancelled_write_bytes" ? &c.cancelledWriteBytes
+                         : key == "syscr" ? &c.syscr
+                         : key == "syscw" ? &c.syscw : nullptr;
+        if (field) { *field = parseLL(v, end); found++; }
+    }
+    return found == 5;
+}
+
+void ProcIoTracker::update(const ProcTickTable& oldTicks, const std::vector<ProcRecord>& records, double now) {
+    tick++;
+    reads = 0;
+    top.clear();
+    std::sort(topPids.begin(), topPids.end());
+
+    ranked.clear();
+    for (size_t i = 0; i < records.size(); i++) {
+        const ProcRecord& r = records[i];
+        const long long* oldJiffies = oldTicks.find(r.pid, r.starttime);
+        bool active = oldJiffies && r.utime + r.stime != *oldJiffies;
+        if (!active && !std::binary_search(topPids.begin(), topPids.end(), r.pid)) continue;
+
+        Counters c;
+        reads++;
+        if (!readCounters(r.pid, c)) continue;
+        auto it = entries.find(r.pid);
+        if (it == entries.end() || it->second.starttime != r.starttime) {
+            Entry e = {r.starttime, now, tick, c, ProcIoRates{}, false};
+            entries[r.pid] = e;
+            continue;
+        }
+        Entry& e = it->second;
+        double dt = now - e.readAt;
+        if (dt <= 0) continue;
+        auto rate = [&](long long cur, long long prev) { return cur >= prev ? (float)((cur - prev) / dt) : 0.0f; };
+        e.rates.readBytesPerSec = rate(c.readBytes, e.counters.readBytes);
+        e.rates.writeBytesPerSec = rate(c.writeBytes, e.counters.writeBytes);
+        e.rates.cancelledWriteBytesPerSec = rate(c.cancelledWriteBytes, e.counters.cancelledWriteBytes);
+        e.rates.syscrPerSec = rate(c.syscr, e.counters.syscr);
+        e.rates.syscwPerSec = rate(c.syscw, e.counters.syscw);
+        e.hasRates = true;
+        e.counters = c;
+        e.readAt = now;
+        e.tick = tick;
+
+        float bytes = e.rates.readBytesPerSec + e.rates.writeBytesPerSec;
+        float syscalls = e.rates.syscrPerSec + e.rates.syscwPerSec;
+        if (bytes > 0 || syscalls > 0) ranked.push_back({bytes, syscalls, r.pid, (unsigned)i});
+    }
+
+    // Few processes are read per tick, so a partial sort of all of them is cheap.
+    auto ranksAbove = [](const Ranked& a, const Ranked& b) {
+        if (a.bytes != b.bytes) return a.bytes > b.bytes;
+        if (a.syscalls != b.syscalls) return a.syscalls > b.syscalls;
+        return a.pid < b.pid;
+    };
+    size_t n = std::min(ranked.size(), (size_t)TopCount);
+    std::partial_sort(ranked.begin(), ranked.begin() + n, ranked.end(), ranksAbove);
+    topPids.clear();
+    for (size_t i = 0; i < n; i++) {
+        top.push_back(ranked[i].index);
+        topPids.push_back(ranked[i].pid);
+    }
+
+    // Drop processes that exited or stayed idle for a long time; an idle process
+    // that wakes up again simply starts from a fresh baseline.
+    for (auto it = entries.begin(); it != entries.end();)
+        it = now - it->second.readAt > ForgetAfter ? entries.erase(it) : std::next(it);
+}
+
+const ProcIoRates* ProcIoTracker::find(int pid, long long starttime) const {
+    auto it = entries.find(pid);
+    if (it == entries.end()) return nullptr;
+    const Entry& e = it->second;
+    return e.starttime == starttime && e.tick == tick && e.hasRates ? &e.rates : nullptr;
+}
+
+ProcMemTracker::~ProcMemTracker() {
+    if (dirFd >= 0) close(dirFd);
+}
+
+// USS is what the process alone maps: its private clean and dirty pages.
+bool ProcMemTracker::readRollup(int pid, Usage& u) {
+    char buf[4096];
+    ssize_t len = readPidFile(dirFd, dirGeneration, pid, "smaps_rollup", buf, sizeof(buf));
+    if (len <= 0) return false;
+
+    long long pss = -1, privateKB = 0, swap = 0;
+    const char* end = buf + len;
+    for (const char* p = skipLine(buf, end); p < end; p = skipLine(p, end)) { // first line is the address range
+        const char* colon = (const char*)memchr(p, ':', end - p);
+        if (!colon) break;
+        std::string_view key(p, colon - p);
+        const char* v = colon + 1;
+        if (key == "Pss") pss = parseLL(v, end);
+        else if (key == "Private_Clean" || key == "Private_Dirty" || key == "Private_Hugetlb") privateKB += parseLL(v, end);
+        else if (key == "Swap") swap = parseLL(v, end);
+    }
+    if (pss < 0) {
+        errno = EINVAL;
+        return false;
+    }
+    u.pssMB = pss / 1024.0f;
+    u.ussMB = privateKB / 1024.0f;
+    u.swapMB = swap / 1024.0f;
+    return true;
+}
+
+void ProcMemTracker::update(const std::vector<ProcRecord>& records, double now) {
+    tick++;
+    reads = 0;
+    pending = 0;
+    candidates.clear();
+    for (size_t i = 0; i < records.size(); i++) {
+        const ProcRecord& r = records[i];
+        if (r.rss <= 0) continue; // kernel threads and zombies have no mappings
+        auto it = entries.find(r.pid);
+        if (it != entries.end() && it->second.starttime != r.starttime) {
+            entries.erase(it);
+            it = entries.end();
+        }
+        double score;
+        if (it == entries.end()) {
+            score = 2e18 + r.rss; // never read: largest first
+            pending++;
+        } else {
+            Entry& e = it->second;
+            e.seen = tick;
+            if (e.denied) continue;
+            double age = now - e.usage.readAt;
+            double drift = (double)(r.rss > e.rssAtRead ? r.rss - e.rssAtRead : e.rssAtRead - r.rss);
+            if (drift == 0 && age < MinAge) continue; // nothing suggests it changed
+            score = age >= MaxAge ? 1e18 + age : (r.rss + DriftWeight * drift) * age;
+        }
+        candidates.push_back({score, (unsigned)i});
+    }
+
+    // Only about as many as the budget allows need to be in order.
+    size_t k = std::min(candidates.size(), (size_t)std::max(16.0, 2 * Budget / avgReadSeconds));
+    std::partial_sort(candidates.begin(), candidates.begin() + k, candidates.end(),
+                      [](const Candidate& a, const Candidate& b) { return a.score > b.score; });
+    double start = monotonicSeconds(), t = start;
+    for (size_t c = 0; c < k && (c == 0 || t - start < Budget); c++) {
+        const ProcRecord& r = records[candidates[c].index];
+        Usage u;
+        bool ok = readRollup(r.pid, u);
+        bool denied = !ok && (errno == EACCES || errno == EPERM);
+        double after = monotonicSeconds();
+        avgReadSeconds += ((after - t) - avgReadSeconds) * 0.1;
+        t = after;
+        reads++;
+        if (!ok && !denied) continue; // exited since the walk
+        auto it = entries.find(r.pid);
+        if (it == entries.end()) {
+            pending--;
+            it = entries.emplace(r.pid, Entry{r.starttime, 0, tick, false, Usage{0, 0, 0, 0}}).first;
+        }
+        Entry& e = it->second;
+        e.rssAtRead = r.rss;
+        e.denied = denied;
+        if (ok) {
+            u.readAt = now;
+            e.usage = u;
+        }
+    }
+
+    for (auto it = entries.begin(); it != entries.end();)
+        it = it->second.seen == tick ? std::next(it) : entries.erase(it);
+}
+
+const ProcMemTracker::Usage* ProcMemTracker::find(int pid, long long starttime) const {
+    auto it = entries.find(pid);
+    if (it == entries.end()) return nullptr;
+    const Entry& e = it->second;
+    return e.starttime == starttime && !e.denied ? &e.usage : nullptr;
+}
+
+ProcSchedTracker::~ProcSchedTracker() {
+    if (dirFd >= 0) close(dirFd);
+}
+
+// Waiting time and timeslices accumulated over seconds, as a SchedDelay.
+static SchedDelay schedDelayOf(long long waitNs, long long timeslices, double seconds) {
+    SchedDelay d = {0, 0, 0};
+    if (seconds <= 0) return d;
+    d.delayMsPerSec = (float)(waitNs / 1e6 / seconds);
+    d.avgDelayMs = timeslices > 0 ? (float)(waitNs / 1e6 / timeslices) : 0;
+    d.timeslicesPerSec = (float)(timeslices / seconds);
+    return d;
+}
+
+// "<run ns> <wait ns> <timeslices>\n"
+static bool parseSchedStat(const char* p, const char* end, long long& runNs, long long& waitNs, long long& timeslices) {
+    const char* start = p;
+    runNs = parseLL(p, end);
+    waitNs = parseLL(p, end);
+    timeslices = parseLL(p, end);
+    return p > start && p < end && *p == '\n';
+}
+
+bool ProcSchedTracker::readCounters(int pid, int threads, Counters& c) {
+    char buf[128];
+    long long run, wait, slices;
+    c = Counters{0, 0, 0};
+    if (threads > 1 && openProcDir(dirFd, dirGeneration)) {
+        char path[32];
+        snprintf(path, sizeof(path), "%d/task", pid);
+        int taskFd = openat(dirFd, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        countSyscalls();
+        DIR* d = taskFd >= 0 ? fdopendir(taskFd) : nullptr;
+        if (d) {
+            int summed = 0;
+            struct dirent* entry;
+            while ((entry = readdir(d)) != NULL) {
+                countSyscalls();
+                if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+                char threadPath[sizeof(entry->d_name) + 16];
+                snprintf(threadPath, sizeof(threadPath), "%s/schedstat", entry->d_name);
+                int fd = openat(dirfd(d), threadPath, O_RDONLY | O_CLOEXEC);
+                countSyscalls();
+                if (fd < 0) continue; // thread exited meanwhile
+                ssize_t len = read(fd, buf, sizeof(buf));
+                close(fd);
+                countSyscalls(2);
+                reads++;
+                if (len <= 0 || !parseSchedStat(buf, buf + len, run, wait, slices)) continue;
+                c.runNs += run;
+                c.waitNs += wait;
+                c.timeslices += slices;
+                summed++;
+            }
+            closedir(d);
+            countSyscalls();
+            if (summed > 0) return true;
+        } else if (taskFd >= 0) {
+            close(taskFd);
+            countSyscalls();
+        }
+        // No task directory (e.g. a fixture tree): fall back to the main thread.
+    }
+    ssize_t len = readPidFile(dirFd, dirGeneration, pid, "schedstat", buf, sizeof(buf));
+    reads++;
+    if (len <= 0 || !parseSchedStat(buf, buf + len, run, wait, slices)) return false;
+    c = Counters{run, wait, slices};
+    return true;
+}
+
+void ProcSchedTracker::update(const ProcTickTable& oldTicks, const std::vector<ProcRecord>& records, double now) {
+    tick++;
+    reads = 0;
+    for (const ProcRecord& r : records) {
+        // A process that waited without ever getting the CPU is exactly the one
+        // to catch, so runnable processes are read even if their ticks stood still.
+        const long long* oldJiffies = oldTicks.find(r.pid, r.starttime);
+        bool ran = oldJiffies && r.utime + r.stime != *oldJiffies;
+        if (!ran && r.state != 'R') continue;
+
+        Counters c;
+        if (!readCounters(r.pid, r.numThreads, c)) continue;
+        auto it = entries.find(r.pid);
+        if (it == entries.end() || it->second.starttime != r.starttime) {
+            Entry e = {r.starttime, now, tick, c, SchedDelay{}, false};
+            entries[r.pid] = e;
+            continue;
+        }
+        Entry& e = it->second;
+        double dt = now - e.readAt;
+        if (dt <= 0) continue;
+        // Threads that exited take their counters with them, so a sum can go
+        // backwards; that interval then reads as zero rather than negative.
+        e.delay = schedDelayOf(std::max(0LL, c.waitNs - e.counters.waitNs),
+                               std::max(0LL, c.timeslices - e.counters.timeslices), dt);
+        e.hasDelay = true;
+        e.counters = c;
+        e.readAt = now;
+        e.tick = tick;
+    }
+    for (auto it = entries.begin(); it != entries.end();)
+        it = now - it->second.readAt > ForgetAfter ? entries.erase(it) : std::next(it);
+}
+
+const SchedDelay* ProcSchedTracker::find(int pid, long long starttime) const {
+    auto it = entries.find(pid);
+    if (it == entries.end()) return nullptr;
+    const Entry& e = it->second;
+    return e.starttime == starttime && e.tick == tick && e.hasDelay ? &e.delay : nullptr;
+}
+
+static float cpuPercentOf(const ProcTickTable& oldTicks, const ProcRecord& r, long long totalCpuDelta) {
+    const long long* oldJiffies = oldTicks.find(r.pid, r.starttime);
+    if (!oldJiffies || totalCpuDelta <= 0) return 0;
+    return (float)((r.utime + r.stime) - *oldJiffies) / (float)totalCpuDelta * 100.0f;
+}
+
+static ProcessInfo makeProcessInfo(const ProcRecord& r, float cpuPercent, const ProcIoTracker* io, const ProcMemTracker* mem,
+                                   const ProcSchedTracker* sched) {
+    static const long long pageSize = sysconf(_SC_PAGESIZE);
+    ProcessInfo pi;
+    pi.name = r.comm;
+    pi.pid = r.pid;
+    pi.starttime = r.starttime;
+    pi.cpuPercent = cpuPercent;
+    pi.memMB = (r.rss * pageSize) / (1024.0f * 1024.0f);
+    pi.threadCount = r.numThreads;
+    pi.state = r.state;
+    const ProcIoRates* rates = io ? io->find(r.pid, r.starttime) : nullptr;
+    pi.ioSampled = rates != nullptr;
+    pi.io = rates ? *rates : ProcIoRates{};
+    const ProcMemTracker::Usage* usage = mem ? mem->find(r.pid, r.starttime) : nullptr;
+    pi.memSampled = usage != nullptr;
+    pi.pssMB = usage ? usage->pssMB : 0;
+    pi.ussMB = usage ? usage->ussMB : 0;
+    pi.swapMB = usage ? usage->swapMB : 0;
+    pi.memAge = usage ? (float)(monotonicSeconds() - usage->readAt) : 0;
+    const SchedDelay* delay = sched ? sched->find(r.pid, r.starttime) : nullptr;
+    pi.schedSampled = delay != nullptr;
+    pi.sched = delay ? *delay : SchedDelay{0, 0, 0};
+    return pi;
+}
+
+struct TopCandidate { float score; int pid; unsigned index; };
+
+// Selects the maxCount highest-scoring records with a bounded min-heap over
+// compact (score, record index) pairs, best first, so ProcessInfo (and its name
+// string) is only materialised for the winners. Allocation is O(maxCount)
+// regardless of process count.
+template <typename ScoreFn>
+static std::vector<TopCandidate> selectTop(const std::vector<ProcRecord>& records, int maxCount, ScoreFn score) {
+    // "a ranks above b": higher score first, lower pid breaks ties deterministically
+    auto ranksAbove = [](const TopCandidate& a, const TopCandidate& b) {
+        return a.score != b.score ? a.score > b.score : a.pid < b.pid;
+    };
+
+    std::vector<TopCandidate> heap; // heap.front() is the weakest of the current top set
+    if (maxCount <= 0) return heap;
+    heap.reserve(maxCount);
+
+    for (size_t i = 0; i < records.size(); i++) {
+        const ProcRecord& r = records[i];
+        TopCandidate c = {score(r), r.pid, (unsigned)i};
+        if ((int)heap.size() < maxCount) {
+            heap.push_back(c);
+            std::push_heap(heap.begin(), heap.end(), ranksAbove);
+        } else if (ranksAbove(c, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), ranksAbove);
+            heap.back() = c;
+            std::push_heap(heap.begin(), heap.end(), ranksAbove);
+        }
+    }
+    std::sort(heap.begin(), heap.end(), ranksAbove);
+    return heap;
+}
+
+std::vector<ProcessInfo> getTopProcesses(const ProcTickTable& oldTicks, const std::vector<ProcRecord>& newTicks, long long totalCpuDelta, int maxCount,
+                                         const ProcIoTracker* io, const ProcMemTracker* mem, const ProcSchedTracker* sched) {
+    std::vector<TopCandidate> top = selectTop(newTicks, maxCount, [&](const ProcRecord& r) {
+        return cpuPercentOf(oldTicks, r, totalCpuDelta);
+    });
+    std::vector<ProcessInfo> procs;
+    procs.reserve(top.size());
+    for (const TopCandidate& c : top) procs.push_back(makeProcessInfo(newTicks[c.index], c.score, io, mem, sched));
+    return procs;
+}
+
+std::vector<ProcessInfo> getTopIoProcesses(const ProcTickTable& oldTicks, const std::vector<ProcRecord>& newTicks, long long totalCpuDelta,
+                                           const ProcIoTracker& io, const ProcMemTracker* mem, const ProcSchedTracker* sched) {
+    std::vector<ProcessInfo> procs;
+    procs.reserve(io.topIndices().size());
+    for (unsigned index : io.topIndices()) {
+        const ProcRecord& r = newTicks[index];
+        procs.push_back(makeProcessInfo(r, cpuPercentOf(oldTicks, r, totalCpuDelta), &io, mem, sched));
+    }
+    return procs;
+}
+
+std::vector<ProcessInfo> getTopMemProcesses(const ProcTickTable& oldTicks, const std::vector<ProcRecord>& newTicks, long long totalCpuDelta,
+                                            const ProcMemTracker& mem, int maxCount, const ProcIoTracker* io,
+                                            const ProcSchedTracker* sched) {
+    static const float pageKB = sysconf(_SC_PAGESIZE) / 1024.0f;
+    std::vector<TopCandidate> top = selectTop(newTicks, maxCount, [&](const ProcRecord& r) {
+        const ProcMemTracker::Usage* u = mem.find(r.pid, r.starttime);
+        return u ? u->pssMB * 1024.0f : r.rss * pageKB;
+    });
+    std::vector<ProcessInfo> procs;
+    procs.reserve(top.size());
+    for (const TopCandidate& c : top) {
+        const ProcRecord& r = newTicks[c.index];
+        procs.push_back(makeProcessInfo(r, cpuPercentOf(oldTicks, r, totalCpuDelta), io, &mem, sched));
+    }
+    return procs;
+}
+
+// ==================== CGROUPS ====================
+bool CgroupCollector::PathLess::operator()(const std::string& a, const std::string& b) const {
+    size_t n = std::min(a.size(), b.size());
+    for (size_t i = 0; i < n; i++) {
+        if (a[i] == b[i]) continue;
+        if (a[i] == '/') return true;
+        if (b[i] == '/') return false;
+        return (unsigned char)a[i] < (unsigned char)b[i];
+    }
+    return a.size() < b.size();
+}
+
+// Where the unified hierarchy is mounted: /sys/fs/cgroup on pure v2 systems,
+// often /sys/fs/cgroup/unified on hybrid ones. Fixture roots use <sys>/fs/cgroup.
+static std::string findCgroup2Mount() {
+    std::string fallback = hostPath("/sys/fs/cgroup");
+    if (fallback != "/sys/fs/cgroup") return fallback;
+    std::ifstream mountinfo("/proc/self/mountinfo");
+    std::string line;
+    while (getline(mountinfo, line)) {
+        size_t sep = line.find(" - cgroup2 ");
+        if (sep == std::string::npos) continue;
+        std::istringstream fields(line.substr(0, sep));
+        std::string id, parent, device, fsRoot, mountPoint;
+        if (fields >> id >> parent >> device >> fsRoot >> mountPoint) {
+            unescapeMountPath(mountPoint);
+            return mountPoint;
+        }
+    }
+    countSyscalls();
+    return access((fallback + "/cgroup.controllers").c_str(), F_OK) == 0 ? fallback : std::string();
+}
+
+CgroupCollector::~CgroupCollector() {
+    close();
+}
+
+void CgroupCollector::close() {
+    if (inotifyFd >= 0) { ::close(inotifyFd); countSyscalls(); } // drops every watch
+    inotifyFd = -1;
+    watchesExhausted = false;
+    nodes.clear();
+    watches.clear();
+}
+
+void CgroupCollector::open() {
+    close();
+    rootGeneration = hostRootsGeneration;
+    root = findCgroup2Mount();
+    if (root.empty()) return;
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    cpuCount = n > 0 ? (int)n : 1;
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    countSyscalls();
+    needResync = true;
+}
+
+// Adds path (and everything below it) that is not known yet and refreshes the
+// populated flag of everything it passes.
+void CgroupCollector::walk(const std::string& path, int depth) {
+    auto it = nodes.find(path);
+    if (it == nodes.end()) {
+        it = nodes.emplace(path, Node()).first;
+        Node& node = it->second;
+        node.depth = depth;
+        size_t slash = path.rfind('/');
+        node.info.name = path.empty() ? "/" : path.substr(slash + 1);
+        node.info.path = path.empty() ? "/" : path;
+        node.info.depth = depth;
+        if (inotifyFd >= 0 && !watchesExhausted) {
+            std::string dir = root + path;
+            node.wd = inotify_add_watch(inotifyFd, dir.c_str(),
+                                        IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY | IN_ONLYDIR);
+            countSyscalls();
+            if (node.wd >= 0) watches[node.wd] = path;
+            else if (errno == ENOSPC) watchesExhausted = true; // fs.inotify.max_user_watches
+        }
+    }
+    it->second.walked = walkGeneration;
+    readEvents(path, it->second);
+
+    std::string dir = root + path;
+    DIR* d = opendir(dir.c_str());
+    countSyscalls();
+    if (!d) return;
+    walks++;
+    struct dirent* entry;
+    std::vector<std::string> children;
+    while ((entry = readdir(d)) != NULL) {
+        if (entry->d_type != DT_DIR || entry->d_name[0] == '.') continue;
+        children.push_back(path + "/" + entry->d_name);
+    }
+    closedir(d);
+    countSyscalls();
+    for (const std::string& child : children) walk(child, depth + 1);
+}
+
+void CgroupCollector::removeSubtree(const std::string& path) {
+    std::string prefix = path + "/";
+    for (auto it = nodes.lower_bound(path); it != nodes.end();) {
+        if (it->first != path && it->first.compare(0, prefix.size(), prefix) != 0) break;
+        if (it->second.wd >= 0) {
+            // Usually already gone with the directory; then this fails harmlessly.
+            inotify_rm_watch(inotifyFd, it->second.wd);
+            countSyscalls();
+            watches.erase(it->second.wd);
+        }
+        it = nodes.erase(it);
+    }
+}
+
+void CgroupCollector::drainEvents() {
+    alignas(struct inotify_event) char events[8192];
+    for (;;) {
+        ssize_t n = read(inotifyFd, events, sizeof(events));
+        countSyscalls();
+        if (n <= 0) return;
+        for (const char* p = events; p < events + n;) {
+            const struct inotify_event* ev = (const struct inotify_event*)p;
+            p += sizeof(struct inotify_event) + ev->len;
+            if (ev->mask & IN_Q_OVERFLOW) { needResync = true; continue; }
+            auto w = watches.find(ev->wd);
+            if (w == watches.end()) continue;
+            if (ev->mask & IN_IGNORED) { // directory removed (or watch dropped)
+                auto node = nodes.find(w->second);
+                if (node != nodes.end()) node->second.wd = -1;
+                watches.erase(w);
+                continue;
+            }
+            const std::string parent = w->second;
+            auto node = nodes.find(parent);
+            if (node == nodes.end() || ev->len == 0) continue;
+            const char* name = ev->name;
+            if ((ev->mask & IN_ISDIR) && (ev->mask & (IN_CREATE | IN_MOVED_TO))) {
+                walk(parent + "/" + name, node->second.depth + 1);
+            } else if ((ev->mask & IN_ISDIR) && (ev->mask & (IN_DELETE | IN_MOVED_FROM))) {
+                removeSubtree(parent + "/" + name);
+            } else if ((ev->mask & IN_MODIFY) && strcmp(name, "cgroup.events") == 0) {
+                readEvents(parent, node->second);
+            }
+        }
+    }
+}
+
+// cgroup.events is "populated 0|1\nfrozen 0|1\n". The root has none and is always populated.
+void CgroupCollector::readEvents(const std::string& path, Node& node) {
+    bool populated = true;
+    if (!path.empty() && readFile(path, "cgroup.events")) {
+        const char* end = buf.data() + len;
+        for (const char* p = buf.data(); p < end; p = skipLine(p, end)) {
+            if (startsWith(p, end, "populated ")) {
+                p += 10;
+                populated = parseLL(p, end) != 0;
+            }
+        }
+    }
+    if (populated != node.populated) {
+        node.needsRead = true;                 // one last read when emptied
+        if (populated) node.hasPrev = false;   // counters sat still meanwhile
+        node.populated = populated;
+    }
+}
+
+bool CgroupCollector::readFile(const std::string& path, const char* name) {
+    filePath.assign(root).append(path).append(1, '/').append(name);
+    int fd = ::open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    countSyscalls();
+    len = 0;
+    if (fd < 0) return false;
+    if (buf.size() < 4096) buf.resize(4096);
+    for (;;) {
+        ssize_t n = read(fd, buf.data() + len, buf.size() - len);
+        countSyscalls();
+        if (n <= 0) break;
+        len += n;
+        if (len < buf.size()) break; // cgroup files are generated in one go
+        buf.resize(buf.size() * 2);
+    }
+    ::close(fd);
+    countSyscalls();
+    return len > 0;
+}
+
+void CgroupCollector::readGroup(const std::string& path, Node& node, double now) {
+    CgroupInfo& c = node.info;
+    c.populated = node.populated;
+    Counters cur = {0, 0, 0, 0, 0, -1, -1, -1};
+    bool haveCpu = false;
+    if (readFile(path, "cpu.stat")) {
+        const char* end = buf.data() + len;
+        for (const char* p = buf.data(); p < end; p = skipLine(p, end)) {
+            if (startsWith(p, end, "usage_usec ")) { p += 11; cur.usageUsec = parseLL(p, end); haveCpu = true; }
+            else if (startsWith(p, end, "throttled_usec ")) { p += 15; cur.throttledUsec = parseLL(p, end); }
+        }
+    }
+    // io.stat: one "MAJ:MIN rbytes=N wbytes=N rios=N wios=N dbytes=N dios=N" line per device
+    if (readFile(path, "io.stat")) {
+        const char* end = buf.data() + len;
+        for (const char* p = buf.data(); p < end;) {
+            const char* eol = (const char*)memchr(p, '\n', end - p);
+            if (!eol) eol = end;
+            for (const char* q = p; q < eol; q++) {
+                if (*q != ' ') continue;
+                const char* key = q + 1;
+                const char* eq = (const char*)memchr(key, '=', eol - key);
+                if (!eq) break;
+                const char* v = eq + 1;
+                long long value = parseLL(v, eol);
+                std::string_view k(key, eq - key);
+                if (k == "rbytes") cur.ioReadBytes += value;
+                else if (k == "wbytes") cur.ioWriteBytes += value;
+                else if (k == "rios" || k == "wios") cur.ioOps += value;
+                q = v - 1;
+            }
+            p = eol + 1;
+        }
+    }
+
+    c.memoryBytes = c.anonBytes = c.fileBytes = c.pids = -1;
+    if (readFile(path, "memory.current")) {
+        const char* p = buf.data();
+        c.memoryBytes = parseLL(p, buf.data() + len);
+    }
+    if (readFile(path, "memory.stat")) {
+        const char* end = buf.data() + len;
+        for (const char* p = buf.data(); p < end; p = skipLine(p, end)) {
+            if (startsWith(p, end, "anon ")) { p += 5; c.anonBytes = parseLL(p, end); }
+            else if (startsWith(p, end, "file ")) { p += 5; c.fileBytes = parseLL(p, end); }
+        }
+    }
+    if (readFile(path, "pids.current")) {
+        const char* p = buf.data();
+        c.pids = parseLL(p, buf.data() + len);
+    }
+    // PSI: only the "some" totals, whose deltas give the stall share of the interval.
+    static const char* const pressureFiles[3] = {"cpu.pressure", "memory.pressure", "io.pressure"};
+    long long* someTotals[3] = {&cur.cpuSomeUsec, &cur.memorySomeUsec, &cur.ioSomeUsec};
+    for (int i = 0; i < 3; i++) {
+        PressureInfo psi;
+        if (readFile(path, pressureFiles[i]) && parsePressure(buf.data(), buf.data() + len, psi))
+            *someTotals[i] = psi.some.totalUsec;
+    }
+
+    double dt = now - node.prevAt;
+    auto rate = [&](long long a, long long b) { return a >= b ? (float)((a - b) / dt) : 0.0f; };
+    if (node.hasPrev && dt > 0) {
+        c.cpuPercent = rate(cur.usageUsec, node.prev.usageUsec) / (1e6f * cpuCount) * 100.0f;
+        c.throttledPercent = rate(cur.throttledUsec, node.prev.throttledUsec) / 1e6f * 100.0f;
+        c.ioReadBytesPerSec = rate(cur.ioReadBytes, node.prev.ioReadBytes);
+        c.ioWriteBytesPerSec = rate(cur.ioWriteBytes, node.prev.ioWriteBytes);
+        c.ioOpsPerSec = rate(cur.ioOps, node.prev.ioOps);
+    } else {
+        c.cpuPercent = c.throttledPercent = c.ioReadBytesPerSec = c.ioWriteBytesPerSec = c.ioOpsPerSec = 0;
+    }
+    auto stall = [&](long long a, long long b) {
+        if (a < 0) return -1.0f;
+        return node.hasPrev && dt > 0 && b >= 0 ? std::min(100.0f, rate(a, b) / 1e4f) : 0.0f;
+    };
+    c.cpuPressure = stall(cur.cpuSomeUsec, node.prev.cpuSomeUsec);
+    c.memoryPressure = stall(cur.memorySomeUsec, node.prev.memorySomeUsec);
+    c.ioPressure = stall(cur.ioSomeUsec, node.prev.ioSomeUsec);
+    node.prev = cur;
+    node.prevAt = now;
+    node.hasPrev = haveCpu;
+    node.needsRead = false;
+}
+
+void CgroupCollector::update(std::vector<CgroupInfo>& out, double now) {
+    if (rootGeneration != hostRootsGeneration) open();
+    if (root.empty()) { out.clear(); return; }
+    if (inotifyFd >= 0) drainEvents();
+    if (needResync || ((inotifyFd < 0 || watchesExhausted) && now - lastWalk >= RewalkInterval)) {
+        // Full walk: adds what is missing, then drops what was not seen.
+        walkGeneration++;
+        walk("", 0);
+        for (auto it = nodes.begin(); it != nodes.end();) {
+            if (it->second.walked == walkGeneration) { ++it; continue; }
+            std::string gone = it->first;
+            removeSubtree(gone);
+            it = nodes.lower_bound(gone);
+        }
+        needResync = false;
+        lastWalk = now;
+    }
+
+    size_t count = 0;
+    for (auto& entry : nodes) {
+        Node& node = entry.second;
+        if (node.populated || node.needsRead) {
+            readGroup(entry.first, node, now);
+        } else {
+            CgroupInfo& c = node.info;
+            c.populated = false;
+            c.cpuPercent = c.throttledPercent = c.ioReadBytesPerSec = c.ioWriteBytesPerSec = c.ioOpsPerSec = 0;
+            // Nothing left to stall; -1 (no PSI) stays as it is.
+            c.cpuPressure = std::min(c.cpuPressure, 0.0f);
+            c.memoryPressure = std::min(c.memoryPressure, 0.0f);
+            c.ioPressure = std::min(c.ioPressure, 0.0f);
+        }
+        if (count == out.size()) out.emplace_back();
+        out[count++] = node.info;
+    }
+    out.resize(count);
+}
+
+// ==================== PRESSURE STALL INFORMATION ====================
+bool parsePressure(const char* p, const char* end, PressureInfo& out) {
+    bool haveSome = false;
+    out.full = PressureLine();
+    for (; p < end; p = skipLine(p, end)) {
+        PressureLine* line;
+        if (startsWith(p, end, "some ")) { line = &out.some; haveSome = true; }
+        else if (startsWith(p, end, "full ")) line = &out.full;
+        else continue;
+        const char* eol = (const char*)memchr(p, '\n', end - p);
+        if (!eol) eol = end;
+        for (p += 5; p < eol; p = skipSpaces(p, eol)) {
+            if (startsWith(p, eol, "avg10=")) { p += 6; line->avg10 = (float)parseDouble(p, eol); }
+            else if (startsWith(p, eol, "avg60=")) { p += 6; line->avg60 = (float)parseDouble(p, eol); }
+            else if (startsWith(p, eol, "avg300=")) { p += 7; line->avg300 = (float)parseDouble(p, eol); }
+            else if (startsWith(p, eol, "total=")) { p += 6; line->totalUsec = parseLL(p, eol); }
+            else break;
+        }
+    }
+    return haveSome;
+}
+
+void readSystemPressure(SystemPressure& out) {
+    static ProcSource* const sources[3] = {
+        &procSource("/proc/pressure/cpu"), &procSource("/proc/pressure/memory"), &procSource("/proc/pressure/io"),
+    };
+    PressureInfo* const infos[3] = {&out.cpu, &out.memory, &out.io};
+    for (int i = 0; i < 3; i++) {
+        ProcSource& src = *sources[i];
+        infos[i]->available = readSource(src) && parsePressure(src.begin(), src.end(), *infos[i]);
+    }
+}
+
+void pressureRates(const SystemPressure& prev, SystemPressure& cur, double seconds) {
+    auto rates = [seconds](const PressureInfo& p, PressureInfo& c) {
+        auto percent = [&](long long now, long long before) {
+            if (!p.available || !c.available || seconds <= 0 || now < before) return 0.0f;
+            return (float)std::min(100.0, (now - before) / (seconds * 1e4)); // usec per second -> %
+        };
+        c.someRecentPercent = percent(c.some.totalUsec, p.some.totalUsec);
+        c.fullRecentPercent = percent(c.full.totalUsec, p.full.totalUsec);
+    };
+    rates(prev.cpu, cur.cpu);
+    rates(prev.memory, cur.memory);
+    rates(prev.io, cur.io);
+}
+
+// "150ms" -> 150000. Plain numbers are rejected: the unit is easy to get wrong.
+static bool parsePsiDuration(const std::string& token, long long& usec) {
+    const char* text = token.c_str();
+    char* unit;
+    double value = strtod(text, &unit);
+    if (unit == text || !(value > 0)) return false;
+    double scale = strcmp(unit, "us") == 0 ? 1 : strcmp(unit, "ms") == 0 ? 1e3 : strcmp(unit, "s") == 0 ? 1e6 : 0;
+    if (scale == 0) return false;
+    usec = (long long)(value * scale + 0.5);
+    return true;
+}
+
+static std::string formatPsiDuration(long long usec) {
+    char text[32];
+    if (usec % 1000000 == 0) snprintf(text, sizeof(text), "%llds", usec / 1000000);
+    else if (usec % 1000 == 0) snprintf(text, sizeof(text), "%lldms", usec / 1000);
+    else snprintf(text, sizeof(text), "%lldus", usec);
+    return text;
+}
+
+PsiTriggerMonitor::~PsiTriggerMonitor() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    if (wakeFd >= 0) {
+        uint64_t one = 1;
+        ssize_t n = write(wakeFd, &one, sizeof(one));
+        (void)n;
+    }
+    if (worker.joinable()) worker.join();
+    for (Trigger& t : triggers)
+        if (t.fd >= 0) ::close(t.fd);
+    if (wakeFd >= 0) ::close(wakeFd);
+}
+
+bool PsiTriggerMonitor::add(const std::string& spec, std::string& error) {
+    std::istringstream fields(spec);
+    std::string resource, kind, stall, in, window, group, extra;
+    fields >> resource >> kind >> stall >> in >> window >> group >> extra;
+    long long stallUs = 0, windowUs = 0;
+    if (resource != "cpu" && resource != "memory" && resource != "io") {
+        error = "resource must be cpu, memory or io";
+        return false;
+    }
+    if (kind != "some" && kind != "full") {
+        error = "expected some or full after the resource";
+        return false;
+    }
+    if (!parsePsiDuration(stall, stallUs) || in != "in" || !parsePsiDuration(window, windowUs) || !extra.empty()) {
+        error = "expected e.g. \"memory some 150ms in 1s [/cgroup]\"";
+        return false;
+    }
+    // The kernel checks these too, but its EINVAL does not say which one failed.
+    if (windowUs < 500000 || windowUs > 10000000) {
+        error = "window must be between 500ms and 10s";
+        return false;
+    }
+    if (stallUs > windowUs) {
+        error = "stall threshold exceeds the window";
+        return false;
+    }
+
+    std::string path;
+    if (group.empty()) {
+        path = hostPath("/proc/pressure/" + resource);
+    } else {
+        std::string root = findCgroup2Mount();
+        if (root.empty()) {
+            error = "no cgroup v2 hierarchy is mounted";
+            return false;
+        }
+        if (group[0] != '/') group.insert(0, 1, '/');
+        while (group.size() > 1 && group.back() == '/') group.pop_back();
+        path = root + (group == "/" ? "" : group) + "/" + resource + ".pressure";
+    }
+    int fd = ::open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        error = path + ": " + strerror(errno);
+        return false;
+    }
+    char arm[64];
+    int n = snprintf(arm, sizeof(arm), "%s %lld %lld", kind.c_str(), stallUs, windowUs);
+    if (write(fd, arm, n + 1) < 0) { // the kernel's example includes the NUL
+        error = path + ": " + strerror(errno);
+        if (errno == EINVAL && windowUs % 2000000 != 0)
+            error += " (without CAP_SYS_RESOURCE the window must be a multiple of 2s)";
+        ::close(fd);
+        return false;
+    }
+
+    Trigger t;
+    t.fd = fd;
+    t.info.spec = resource + " " + kind + " " + formatPsiDuration(stallUs) + " in " + formatPsiDuration(windowUs);
+    if (!group.empty()) t.info.spec += " " + group;
+    t.info.events = 0;
+    t.info.lastEvent = 0;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (wakeFd < 0) {
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wakeFd < 0) {
+            error = std::string("eventfd: ") + strerror(errno);
+            ::close(fd);
+            return false;
+        }
+        worker = std::thread(&PsiTriggerMonitor::run, this);
+    }
+    triggers.push_back(std::move(t));
+    uint64_t one = 1;
+    ssize_t woken = write(wakeFd, &one, sizeof(one)); // rebuild the poll set
+    (void)woken;
+    return true;
+}
+
+void PsiTriggerMonitor::run() {
+    std::vector<struct pollfd> fds;
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping) return;
+            fds.assign(1, {wakeFd, POLLIN, 0});
+            for (const Trigger& t : triggers) fds.push_back({t.fd, POLLPRI, 0}); // poll() skips fd -1
+        }
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        double now = monotonicSeconds();
+        if (fds[0].revents & POLLIN) {
+            uint64_t count;
+            ssize_t n = read(wakeFd, &count, sizeof(count));
+            (void)n;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 1; i < fds.size(); i++) { // triggers only grow, so indices still match
+            Trigger& t = triggers[i - 1];
+            if (fds[i].revents & (POLLERR | POLLNVAL)) {
+                // The cgroup was removed, or PSI was switched off through cgroup.pressure.
+                ::close(t.fd);
+                t.fd = -1;
+                t.info.error = "pressure file went away";
+            } else if (fds[i].revents & POLLPRI) {
+                t.info.events++;
+                t.info.lastEvent = now;
+                if (t.info.recent.size() == RecentEvents) t.info.recent.erase(t.info.recent.begin());
+                t.info.recent.push_back(now);
+            }
+        }
+    }
+}
+
+void PsiTriggerMonitor::snapshot(std::vector<PsiTriggerInfo>& out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    out.resize(triggers.size());
+    for (size_t i = 0; i < triggers.size(); i++) out[i] = triggers[i].info;
+}
+
+// ==================== SYSTEM INFO ====================
+SystemInfo getSystemInfo() {
+    SystemInfo info;
+
+    // Distro from /etc/os-release
+    std::ifstream osrel("/etc/os-release");
+    std::string line;
+    while (getline(osrel, line)) {
+        if (line.substr(0, 12) == "PRETTY_NAME=") {
+            info.distroName = line.substr(13);
+            if (!info.distroName.empty() && info.distroName.back() == '"')
+                info.distroName.pop_back();
+        } else if (line.substr(0, 11) == "VERSION_ID=") {
+            info.distroVersion = line.substr(12);
+            if (!info.distroVersion.empty() && info.distroVersion.back() == '"')
+                info.distroVersion.pop_back();
+        }
+    }
+
+    // Kernel
+    struct utsname uts;
+    if (uname(&uts) == 0) {
+        info.kernelVersion = uts.release;
+        info.architecture = uts.machine;
+    }
+
+    // Hostname
+    char hostname[256];
+    if (gethostname(hostname, sizeof(hostname)) == 0)
+        info.hostname = hostname;
+
+    // Username
+    struct passwd* pw = getpwuid(getuid());
+    if (pw) info.username = pw->pw_name;
+    else {
+        char* user = getenv("USER");
+        info.username = user ? user : "unknown";
+    }
+
+    info.logicalCores = getCPUCoreCount();
+    info.physicalCores = getPhysicalCoreCount();
+
+    // Total RAM
+    std::ifstream meminfo(hostPath("/proc/meminfo"));
+    while (getline(meminfo, line)) {
+        if (line.substr(0, 9) == "MemTotal:") {
+            std::stringstream ss(line);
+            std::string label; long long val;
+            ss >> label >> val;
+            info.totalRamGB = val / (1024.0f * 1024.0f);
+            break;
+        }
+    }
+
+    return info;
+}
+
+std::string getUptime() {
+    static ProcSource& src = procSource("/proc/uptime");
+    double uptime = 0;
+    if (readSource(src)) {
+        const char* p = src.begin();
+        uptime = parseDouble(p, src.end());
+    }
+    int days = (int)(uptime / 86400);
+    int hours = (int)((uptime - days * 86400) / 3600);
+    int mins = (int)((uptime - days * 86400 - hours * 3600) / 60);
+    std::stringstream ss;
+    if (days > 0) ss << days << "d ";
+    ss << hours << "h " << mins << "m";
+    return ss.str();
+}
+
+int getProcessCount(const std::vector<ProcRecord>& records) {
+    return (int)records.size();
+}
+
+int getTotalThreadCount(const std::vector<ProcRecord>& records) {
+    int total = 0;
+    for (const auto& r : records) total += r.numThreads;
+    return total;
+}
+
+// CPU time (user + system, all threads) and resident set of this process.
+void getSelfUsage(double& cpuSeconds, long long& rssKB) {
+    static ProcSource& statm = procSource("/proc/self/statm");
+    static const long pageKB = sysconf(_SC_PAGESIZE) / 1024;
+    struct rusage ru;
+    countSyscalls();
+    if (getrusage(RUSAGE_SELF, &ru) == 0)
+        cpuSeconds = ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+    if (readSource(statm)) {
+        const char* p = statm.begin();
+        parseLL(p, statm.end()); // size
+        rssKB = parseLL(p, statm.end()) * pageKB;
+    }
+}
+
+int getFileDescriptorCount() {
+    static ProcSource& src = procSource("/proc/sys/fs/file-nr");
+    long long allocated = 0;
+    readSourceLL(src, allocated);
+    return (int)allocated;
+}
+
+// ==================== TIMER WHEEL ====================
+TimerWheel::TimerWheel(double start) : start(start) {
+    for (int i = 0; i < Capacity; i++) level[i] = -1;
+    for (auto& l : slots)
+        for (int& head : l) head = -1;
+}
+
+long long TimerWheel::tickOf(double t) const {
+    return (long long)std::ceil((t - start) / Resolution);
+}
+
+void TimerWheel::insert(int id) {
+    long long d = deadline[id];
+    if (d <= now) {
+        // Already due: handed out by the next advance(), even without a tick.
+        level[id] = Levels;
+        pending |= 1u << id;
+        return;
+    }
+    int lv = 0;
+    while (lv < Levels - 1 && (d >> (lv * SlotBits)) - (now >> (lv * SlotBits)) >= Slots) lv++;
+    int shift = lv * SlotBits;
+    if ((d >> shift) - (now >> shift) >= Slots) d = deadline[id] = ((now >> shift) + Slots - 1) << shift;
+    int& head = slots[lv][(d >> shift) & (Slots - 1)];
+    level[id] = lv;
+    prev[id] = -1;
+    next[id] = head;
+    if (head >= 0) prev[head] = id;
+    head = id;
+}
+
+void TimerWheel::unlink(int id) {
+    int lv = level[id];
+    level[id] = -1;
+    if (lv == Levels) { pending &= ~(1u << id); return; }
+    if (next[id] >= 0) prev[next[id]] = prev[id];
+    if (prev[id] >= 0) next[prev[id]] = next[id];
+    else slots[lv][(deadline[id] >> (lv * SlotBits)) & (Slots - 1)] = next[id];
+}
+
+void TimerWheel::arm(int id, double when) {
+    if (armed(id)) unlink(id);
+    deadline[id] = tickOf(when);
+    insert(id);
+}
+
+void TimerWheel::cancel(int id) {
+    if (armed(id)) unlink(id);
+}
+
+unsigned TimerWheel::advance(double when) {
+    long long target = (long long)std::floor((when - start) / Resolution + 1e-6);
+    if (target - now >= 1LL << (Levels * SlotBits)) {
+        // Longer than the wheel's reach (a suspend): re-bucket every timer.
+        int ids[Capacity], count = 0;
+        for (int id = 0; id < Capacity; id++)
+            if (armed(id)) { unlink(id); ids[count++] = id; }
+        now = target;
+        for (int i = 0; i < count; i++) insert(ids[i]);
+    }
+    while (now < target) {
+        now++;
+        for (int lv = Levels - 1; lv >= 1; lv--) {
+            int shift = lv * SlotBits;
+            if (now & ((1LL << shift) - 1)) continue;
+            int& head = slots[lv][(now >> shift) & (Slots - 1)];
+            int id = head;
+            head = -1;
+            while (id >= 0) {
+                int after = next[id];
+                insert(id); // into a finer level, or pending when due now
+                id = after;
+            }
+        }
+        int& head = slots[0][now & (Slots - 1)];
+        for (int id = head; id >= 0; id = next[id]) {
+            level[id] = -1;
+            pending |= 1u << id;
+        }
+        head = -1;
+    }
+    unsigned expired = pending;
+    for (int id = 0; id < Capacity; id++)
+        if (expired & (1u << id)) level[id] = -1;
+    pending = 0;
+    return expired;
+}
+
+double TimerWheel::nextExpiry() const {
+    if (pending) return start + now * Resolution;
+    // Levels overlap in time, so take the earliest slot of each.
+    long long best = LLONG_MAX;
+    for (int lv = 0; lv < Levels; lv++) {
+        int shift = lv * SlotBits;
+        for (int i = 1; i < Slots; i++) {
+            int id = slots[lv][((now >> shift) + i) & (Slots - 1)];
+            if (id < 0) continue;
+            for (; id >= 0; id = next[id]) best = std::min(best, deadline[id]);
+            break;
+        }
+    }
+    return best == LLONG_MAX ? HUGE_VAL : start + best * Resolution;
+}
+
+// ==================== SAMPLER ====================
+// Dependencies must have lower ids; a pass runs collectors in id order.
+static const CollectorSpec collectorSpecs[COLLECTOR_COUNT] = {
+    {"cpu",       COST_CHEAP,    0,    0},
+    {"pressure",  COST_CHEAP,    0,    0},
+    {"memory",    COST_CHEAP,    0,    0},
+    {"network",   COST_CHEAP,    0,    0},
+    {"disk",      COST_CHEAP,    0,    0},
+    // Process CPU% is a share of the machine's jiffies over the same window.
+    {"processes", COST_MODERATE, 1.0,  1u << COLLECTOR_CPU},
+    {"cgroups",   COST_MODERATE, 1.0,  0},
+    {"gpu",       COST_CHEAP,    0,    0},
+    {"system",    COST_CHEAP,    0,    0},
+    {"sockets",   COST_SLOW,     5.0,  0},
+    {"mounts",    COST_SLOW,     30.0, 0},
+    {"battery",   COST_SLOW,     30.0, 0},
+};
+static_assert(COLLECTOR_COUNT <= TimerWheel::Capacity, "one timer per collector");
+
+// Longest interval the timer wheel can hold without clamping.
+static const double MaxCollectorInterval = 1800;
+
+const CollectorSpec& collectorSpec(CollectorId id) {
+    return collectorSpecs[id];
+}
+
+const char* collectorCostName(CollectorCost cost) {
+    switch (cost) {
+        case COST_CHEAP: return "cheap";
+        case COST_MODERATE: return "moderate";
+        default: return "slow";
+    }
+}
+
+double minCollectorInterval(CollectorCost cost) {
+    switch (cost) {
+        case COST_CHEAP: return 0.05;
+        case COST_MODERATE: return 0.25;
+        default: return 1.0;
+    }
+}
+
+bool findCollector(const std::string& name, CollectorId& id) {
+    for (int i = 0; i < COLLECTOR_COUNT; i++) {
+        if (name != collectorSpecs[i].name) continue;
+        id = (CollectorId)i;
+        return true;
+    }
+    return false;
+}
+
+bool parseCollectorInterval(const std::string& spec, CollectorId& id, double& seconds, std::string& error) {
+    size_t eq = spec.find('=');
+    if (eq == std::string::npos) { error = "expected NAME=SECONDS"; return false; }
+    if (!findCollector(spec.substr(0, eq), id)) {
+        error = "unknown collector (one of";
+        for (const CollectorSpec& c : collectorSpecs) { error += ' '; error += c.name; }
+        error += ')';
+        return false;
+    }
+    char* end = nullptr;
+    seconds = strtod(spec.c_str() + eq + 1, &end);
+    if (end == spec.c_str() + eq + 1 || *end || !(seconds > 0)) { error = "expected a positive number of seconds"; return false; }
+    return true;
+}
+
+static double clampCollectorInterval(CollectorId id, double seconds) {
+    return std::min(MaxCollectorInterval, std::max(seconds, minCollectorInterval(collectorSpecs[id].cost)));
+}
+
+// A collector with a default interval never runs faster than the sampler's.
+Sampler::Sampler(double interval) : interval(interval) {
+    for (int i = 0; i < COLLECTOR_COUNT; i++)
+        intervals[i] = clampCollectorInterval((CollectorId)i, std::max(collectorSpecs[i].defaultInterval, interval));
+}
+
+void Sampler::setCollectorInterval(CollectorId id, double seconds) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        intervals[id] = clampCollectorInterval(id, seconds);
+        intervalsChanged |= 1u << id;
+    }
+    wake.notify_all();
+}
+
+void Sampler::publish(std::shared_ptr<const MetricsSnapshot> snap) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current = std::move(snap);
+    }
+    if (onPublish) onPublish();
+}
+
+// Per-interface rates against the previous dump, matched by name (and ifindex,
+// so a recreated interface starts from zero rather than a bogus delta).
+static void interfaceRates(const std::vector<NetInterfaceStats>& prev, const std::vector<NetInterfaceStats>& cur,
+                           double seconds, std::vector<NetInterfaceInfo>& out) {
+    out.resize(cur.size());
+    for (size_t i = 0; i < cur.size(); i++) {
+        const NetInterfaceStats& c = cur[i];
+        const NetInterfaceStats* p = i < prev.size() && prev[i].name == c.name ? &prev[i] : nullptr;
+        for (size_t j = 0; !p && j < prev.size(); j++)
+            if (prev[j].name == c.name) p = &prev[j];
+        if (p && p->ifindex != c.ifindex) p = nullptr;
+        auto rate = [&](long long now, long long before) {
+            return p && seconds > 0 && now >= before ? (now - before) / seconds : 0.0;
+        };
+        NetInterfaceInfo& o = out[i];
+        o.name = c.name;
+        o.physical = c.physical;
+        o.up = c.up;
+        o.rxBytesPerSec = rate(c.rxBytes, p ? p->rxBytes : 0);
+        o.txBytesPerSec = rate(c.txBytes, p ? p->txBytes : 0);
+        o.rxPacketsPerSec = rate(c.rxPackets, p ? p->rxPackets : 0);
+        o.txPacketsPerSec = rate(c.txPackets, p ? p->txPackets : 0);
+        o.rxDropped = c.rxDropped; o.txDropped = c.txDropped;
+        o.rxErrors = c.rxErrors;   o.txErrors = c.txErrors;
+    }
+    std::sort(out.begin(), out.end(), [](const NetInterfaceInfo& a, const NetInterfaceInfo& b) {
+        return a.physical != b.physical ? a.physical : a.name < b.name;
+    });
+}
+
+// iostat -x over one interval for every whole disk except loop/ram devices,
+// matched to the previous pass by name.
+static void diskDeviceRates(const std::vector<BlockDeviceStats>& prev, const std::vector<BlockDeviceStats>& cur,
+                            double seconds, std::vector<DiskDeviceInfo>& out) {
+    size_t count = 0;
+    double ms = seconds * 1000;
+    for (size_t i = 0; i < cur.size(); i++) {
+        const BlockDeviceStats& c = cur[i];
+        if (!c.wholeDisk || isLoopOrRam(c.name)) continue;
+        const BlockDeviceStats* p = i < prev.size() && prev[i].name == c.name ? &prev[i] : nullptr;
+        for (size_t j = 0; !p && j < prev.size(); j++)
+            if (prev[j].name == c.name) p = &prev[j];
+        // Counters only go backwards when the device was re-created.
+        if (p && (c.reads < p->reads || c.writes < p->writes || c.ioTicks < p->ioTicks)) p = nullptr;
+        const BlockDeviceStats& o = p ? *p : c; // no history: all deltas zero
+
+        long long dReads = c.reads - o.reads, dWrites = c.writes - o.writes;
+        long long dDiscards = c.discards - o.discards, dFlushes = c.flushes - o.flushes;
+        long long dReadTicks = c.readTicks - o.readTicks, dWriteTicks = c.writeTicks - o.writeTicks;
+        long long dAllTicks = dReadTicks + dWriteTicks + (c.discardTicks - o.discardTicks) + (c.flushTicks - o.flushTicks);
+        long long dIos = dReads + dWrites + dDiscards + dFlushes;
+
+        if (count == out.size()) out.emplace_back();
+        DiskDeviceInfo& d = out[count++];
+        d.name = c.name;
+        d.physical = c.physical;
+        d.readsPerSec = seconds > 0 ? dReads / seconds : 0;
+        d.writesPerSec = seconds > 0 ? dWrites / seconds : 0;
+        d.readBytesPerSec = seconds > 0 ? (c.sectorsRead - o.sectorsRead) * 512 / seconds : 0;
+        d.writeBytesPerSec = seconds > 0 ? (c.sectorsWritten - o.sectorsWritten) * 512 / seconds : 0;
+        d.discardsPerSec = seconds > 0 ? dDiscards / seconds : 0;
+        d.flushesPerSec = seconds > 0 ? dFlushes / seconds : 0;
+        d.readAwaitMs = dReads > 0 ? (float)dReadTicks / dReads : 0;
+        d.writeAwaitMs = dWrites > 0 ? (float)dWriteTicks / dWrites : 0;
+        d.awaitMs = dIos > 0 ? (float)dAllTicks / dIos : 0;
+        d.queueDepth = ms > 0 ? (float)((c.timeInQueue - o.timeInQueue) / ms) : 0;
+        d.utilPercent = ms > 0 ? (float)std::min(100.0, (c.ioTicks - o.ioTicks) / ms * 100) : 0;
+        d.inFlight = c.inFlight;
+    }
+    out.resize(count);
+    std::sort(out.begin(), out.end(), [](const DiskDeviceInfo& a, const DiskDeviceInfo& b) {
+        return a.physical != b.physical ? a.physical : a.name < b.name;
+    });
+}
+
+// Run-queue delay per CPU, matched to the previous read by CPU number, so a CPU
+// that went offline and came back starts from zero.
+static void coreSchedDelays(const std::vector<CpuSchedStat>& prev, const std::vector<CpuSchedStat>& cur,
+                            double seconds, std::vector<SchedDelay>& out) {
+    out.resize(cur.size());
+    for (size_t i = 0; i < cur.size(); i++) {
+        const CpuSchedStat& c = cur[i];
+        const CpuSchedStat* p = i < prev.size() && prev[i].cpu == c.cpu ? &prev[i] : nullptr;
+        for (size_t j = 0; !p && j < prev.size(); j++)
+            if (prev[j].cpu == c.cpu) p = &prev[j];
+        if (p && (c.waitNs < p->waitNs || c.timeslices < p->timeslices)) p = nullptr;
+        out[i] = p ? schedDelayOf(c.waitNs - p->waitNs, c.timeslices - p->timeslices, seconds) : SchedDelay{0, 0, 0};
+    }
+}
+
+static long long totalJiffies(const CPUStats& c) {
+    return c.user + c.nice + c.system + c.idle + c.iowait + c.irq + c.softirq + c.steal;
+}
+
+void Sampler::run() {
+    // Baselines for every rate, so each collector's first run has a delta.
+    ProcStatSnapshot oldStat = {}, newStat = {};
+    readProcStatSnapshot(oldStat);
+    CPUStats oldCpu = readCPUStats(oldStat);
+    std::vector<CpuSchedStat> oldSched, newSched;
+    readSchedStat(oldSched);
+    std::vector<NetInterfaceStats> oldIfaces, newIfaces;
+    readNetInterfaces(oldIfaces);
+    NetStats oldNet = sumNetInterfaces(oldIfaces);
+    std::vector<BlockDeviceStats> oldBlocks, newBlocks;
+    readBlockDevices(oldBlocks);
+    DiskStats oldDisk = sumBlockDevices(oldBlocks);
+    SystemPressure oldPressure = {};
+    readSystemPressure(oldPressure);
+    // The /proc walk uses up to half the logical cores (at most 8): it is bound by
+    // per-file syscall latency, not CPU, and must not crowd out the workload.
+    ProcWalker procWalker(std::min(8, std::max(1, getCPUCoreCount() / 2)));
+    std::vector<ProcRecord> procRecords;
+    ProcEventTracker procEvents;
+    bool trackEvents = useProcEvents && procEvents.open();
+    auto walkProcesses = [&] {
+        if (!trackEvents) { procWalker.walk(procRecords); return; }
+        procWalker.read(procEvents.update(), procRecords);
+        procEvents.retain(procRecords);
+    };
+    walkProcesses();
+    auto gpuPeriodMs = [](double seconds) { return std::max(100, (int)(seconds * 1000)); };
+    GpuCollector gpuCollector(gpuPeriodMs(collectorInterval(COLLECTOR_GPU)));
+    FsUsageCollector fsUsage;
+    ProcIoTracker procIo;
+    ProcMemTracker procMem;
+    ProcSchedTracker procSched;
+    CgroupCollector cgroups;
+    ProcTickTable oldProcTicks;
+    oldProcTicks.rebuild(procRecords);
+    CPUStats procCpu = oldCpu; // machine jiffies at the last process pass
+    long long startRx = oldNet.rxBytes, startTx = oldNet.txBytes;
+    long long startDiskRead = oldDisk.readBytes, startDiskWrite = oldDisk.writeBytes;
+    long long prevCtxt = 0, prevIntr = 0;
+    getContextSwitchesAndInterrupts(oldStat, prevCtxt, prevIntr);
+    double prevSelfCpu = 0;
+    long long selfRss = 0;
+    getSelfUsage(prevSelfCpu, selfRss);
+    double start = monotonicSeconds();
+    double pressureAt = start, netAt = start, diskAt = start, selfAt = start;
+
+    auto first = std::make_shared<MetricsSnapshot>();
+    first->memDetail = getMemoryDetail();
+    first->uptime = getUptime();
+    publish(first);
+    std::shared_ptr<const MetricsSnapshot> prev = first;
+
+    // Every collector gets a timer. The first pass comes after a short warm-up
+    // instead of a full interval so it is available within milliseconds; slow
+    // collectors sit it out and join on the sampler's first regular beat.
+    TimerWheel wheel(start);
+    double deadlines[COLLECTOR_COUNT], lastRun[COLLECTOR_COUNT];
+    double current[COLLECTOR_COUNT];
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::copy(intervals, intervals + COLLECTOR_COUNT, current);
+        intervalsChanged = 0;
+    }
+    for (int id = 0; id < COLLECTOR_COUNT; id++) {
+        bool slow = collectorSpecs[id].cost == COST_SLOW;
+        deadlines[id] = start + FirstSampleDelay + (slow ? std::min(current[id], interval) : 0);
+        lastRun[id] = start;
+        wheel.arm(id, deadlines[id]);
+    }
+
+    auto toDuration = [](double seconds) {
+        return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+    };
+    for (;;) {
+        bool gpuChanged = false;
+        {
+            // Sleep until the earliest deadline; an interval change wakes us early.
+            std::unique_lock<std::mutex> lock(mutex);
+            double wait = std::min(wheel.nextExpiry() - monotonicSeconds(), MaxCollectorInterval);
+            auto until = std::chrono::steady_clock::now() + toDuration(std::max(0.0, wait));
+            if (wake.wait_until(lock, until, [this] { return !running || intervalsChanged; }) && !running) break;
+            for (int id = 0; id < COLLECTOR_COUNT; id++) {
+                if (!(intervalsChanged & (1u << id))) continue;
+                current[id] = intervals[id];
+                deadlines[id] = lastRun[id] + current[id];
+                wheel.arm(id, deadlines[id]);
+                if (id == COLLECTOR_GPU) gpuChanged = true;
+            }
+            intervalsChanged = 0;
+        }
+        // Outside the lock: restarting nvidia-smi waits for the old child.
+        if (gpuChanged) gpuCollector.setInterval(gpuPeriodMs(current[COLLECTOR_GPU]));
+        double now = monotonicSeconds();
+        unsigned expired = wheel.advance(now);
+        if (!expired) continue;
+
+        // Re-arm drift-free; a collector that fell a whole interval behind
+        // skips the missed beats instead of running back to back.
+        for (int id = 0; id < COLLECTOR_COUNT; id++) {
+            if (!(expired & (1u << id))) continue;
+            deadlines[id] += current[id];
+            if (deadlines[id] <= now) deadlines[id] = now + current[id];
+            wheel.arm(id, deadlines[id]);
+        }
+        // Dependencies point to lower ids, so one pass downwards closes the set.
+        unsigned due = expired;
+        for (int id = COLLECTOR_COUNT - 1; id >= 0; id--)
+            if (due & (1u << id)) due |= collectorSpecs[id].dependencies;
+        for (int id = 0; id < COLLECTOR_COUNT; id++)
+            if (due & (1u << id)) lastRun[id] = now;
+        auto runs = [due](CollectorId id) { return (due & (1u << id)) != 0; };
+
+        PerfTimer passTimer(PERF_SAMPLER_TICK);
+        // Copies the scalars and shares every section; collectors that run
+        // below replace their own.
+        auto next = std::make_shared<MetricsSnapshot>(*prev);
+        MetricsSnapshot& s = *next;
+        s.sequence = prev->sequence + 1;
+        s.timestamp = now;
+        s.collected = due;
+
+        if (runs(COLLECTOR_CPU)) {
+            {
+                PerfTimer t(PERF_PROC_STAT);
+                readProcStatSnapshot(newStat);
+                readSchedStat(newSched);
+            }
+            double statInterval = newStat.timestamp - oldStat.timestamp;
+            if (statInterval <= 0) statInterval = 1.0;
+            CPUStats newCpu = readCPUStats(newStat);
+            s.cpuUsage = calcCPUUsage(oldCpu, newCpu);
+            if (s.cpuUsage * 100 > s.peakCpu) s.peakCpu = s.cpuUsage * 100;
+
+            // IO Wait percentage
+            long long totalDelta = totalJiffies(newCpu) - totalJiffies(oldCpu);
+            s.ioWaitPct = totalDelta > 0 ? (float)(newCpu.iowait - oldCpu.iowait) / (float)totalDelta * 100.0f : 0;
+
+            // Per-core
+            const std::vector<CPUStats>& oldCoreCpu = readPerCoreCPUStats(oldStat);
+            const std::vector<CPUStats>& newCoreCpu = readPerCoreCPUStats(newStat);
+            auto cores = std::make_shared<std::vector<float>>(newCoreCpu.size());
+            for (size_t i = 0; i < newCoreCpu.size() && i < oldCoreCpu.size(); i++) {
+                (*cores)[i] = calcCPUUsage(oldCoreCpu[i], newCoreCpu[i]) * 100.0f;
+            }
+            s.perCoreUsage = std::move(cores);
+            oldCpu = newCpu;
+            auto coreSched = std::make_shared<std::vector<SchedDelay>>();
+            coreSchedDelays(oldSched, newSched, statInterval, *coreSched);
+            s.coreSched = std::move(coreSched);
+            std::swap(oldSched, newSched);
+
+            {
+                PerfTimer t(PERF_CPU_SENSORS);
+                s.cpuTemp = getCPUTemp();
+                s.cpuFreq = getCPUFrequency();
+                getLoadAverages(s.loadAvg1, s.loadAvg5, s.loadAvg15);
+            }
+
+            // Context switches & interrupts
+            long long curCtxt, curIntr;
+            getContextSwitchesAndInterrupts(newStat, curCtxt, curIntr);
+            s.ctxtPerSec = (float)((curCtxt - prevCtxt) / statInterval);
+            s.intrPerSec = (float)((curIntr - prevIntr) / statInterval);
+            prevCtxt = curCtxt; prevIntr = curIntr;
+            std::swap(oldStat, newStat);
+        }
+
+        if (runs(COLLECTOR_PRESSURE)) {
+            PerfTimer t(PERF_PRESSURE);
+            readSystemPressure(s.pressure);
+            pressureRates(oldPressure, s.pressure, now - pressureAt);
+            oldPressure = s.pressure;
+            pressureAt = now;
+            auto triggers = std::make_shared<std::vector<PsiTriggerInfo>>();
+            psiTriggers.snapshot(*triggers);
+            s.psiTriggers = std::move(triggers);
+        }
+
+        if (runs(COLLECTOR_MEMORY)) {
+            { PerfTimer t(PERF_MEMORY); s.memDetail = getMemoryDetail(); }
+            s.ramUsagePercent = s.memDetail.totalKB > 0 ? (float)(s.memDetail.totalKB - s.memDetail.availableKB) / (float)s.memDetail.totalKB : 0;
+            if (s.ramUsagePercent * 100 > s.peakRam) s.peakRam = s.ramUsagePercent * 100;
+        }
+
+        if (runs(COLLECTOR_NETWORK)) {
+            double seconds = now - netAt;
+            {
+                PerfTimer t(PERF_NETWORK);
+                readNetInterfaces(newIfaces);
+                auto interfaces = std::make_shared<std::vector<NetInterfaceInfo>>();
+                interfaceRates(oldIfaces, newIfaces, seconds, *interfaces);
+                s.interfaces = std::move(interfaces);
+            }
+            NetStats newNet = sumNetInterfaces(newIfaces);
+            s.downSpeed = seconds > 0 ? (newNet.rxBytes - oldNet.rxBytes) / seconds : 0;
+            s.upSpeed = seconds > 0 ? (newNet.txBytes - oldNet.txBytes) / seconds : 0;
+            s.sessionRx = newNet.rxBytes - startRx;
+            s.sessionTx = newNet.txBytes - startTx;
+            oldNet = newNet;
+            std::swap(oldIfaces, newIfaces);
+            netAt = now;
+        }
+
+        if (runs(COLLECTOR_DISK)) {
+            double seconds = now - diskAt;
+            {
+                PerfTimer t(PERF_DISK_STATS);
+                readBlockDevices(newBlocks);
+                auto devices = std::make_shared<std::vector<DiskDeviceInfo>>();
+                diskDeviceRates(oldBlocks, newBlocks, seconds, *devices);
+                s.diskDevices = std::move(devices);
+            }
+            DiskStats newDisk = sumBlockDevices(newBlocks);
+            s.diskReadSpeed = seconds > 0 ? (newDisk.readBytes - oldDisk.readBytes) / seconds : 0;
+            s.diskWriteSpeed = seconds > 0 ? (newDisk.writeBytes - oldDisk.writeBytes) / seconds : 0;
+            s.sessionDiskRead = newDisk.readBytes - startDiskRead;
+            s.sessionDiskWrite = newDisk.writeBytes - startDiskWrite;
+            oldDisk = newDisk;
+            std::swap(oldBlocks, newBlocks);
+            diskAt = now;
+        }
+
+        if (runs(COLLECTOR_PROCESSES)) {
+            { PerfTimer t(PERF_PROC_WALK); walkProcesses(); }
+            // oldCpu was refreshed by this pass (processes depend on cpu).
+            long long totalDelta = totalJiffies(oldCpu) - totalJiffies(procCpu);
+            long long totalCpuJiffies = totalDelta > 0 ? totalDelta : 1;
+            procCpu = oldCpu;
+            {
+                PerfTimer t(PERF_PROC_IO);
+                procIo.update(oldProcTicks, procRecords, now);
+                s.procIoReads = (int)procIo.lastReadCount();
+            }
+            {
+                PerfTimer t(PERF_PROC_SMAPS);
+                procMem.update(procRecords, now);
+                s.procSmapsReads = (int)procMem.lastReadCount();
+                s.procSmapsPending = (int)procMem.pendingCount();
+            }
+            {
+                PerfTimer t(PERF_PROC_SCHED);
+                procSched.update(oldProcTicks, procRecords, now);
+                s.procSchedReads = (int)procSched.lastReadCount();
+            }
+            {
+                PerfTimer t(PERF_TOP_PROCESSES);
+                s.topProcesses = std::make_shared<const std::vector<ProcessInfo>>(
+                    getTopProcesses(oldProcTicks, procRecords, totalCpuJiffies, 25, &procIo, &procMem, &procSched));
+                s.topIoProcesses = std::make_shared<const std::vector<ProcessInfo>>(
+                    getTopIoProcesses(oldProcTicks, procRecords, totalCpuJiffies, procIo, &procMem, &procSched));
+                s.topMemProcesses = std::make_shared<const std::vector<ProcessInfo>>(
+                    getTopMemProcesses(oldProcTicks, procRecords, totalCpuJiffies, procMem, 25, &procIo, &procSched));
+                oldProcTicks.rebuild(procRecords);
+            }
+            s.processCount = getProcessCount(procRecords);
+            s.procEvents = trackEvents;
+            s.threadCount = getTotalThreadCount(procRecords);
+        }
+
+        if (runs(COLLECTOR_CGROUPS)) {
+            PerfTimer t(PERF_CGROUPS);
+            auto groups = std::make_shared<std::vector<CgroupInfo>>();
+            cgroups.update(*groups, now);
+            s.cgroups = std::move(groups);
+            s.cgroupsWatched = cgroups.watching();
+        }
+
+        if (runs(COLLECTOR_GPU)) {
+            PerfTimer t(PERF_GPU);
+            auto gpus = std::make_shared<std::vector<GPUInfo>>();
+            gpuCollector.poll(*gpus);
+            s.gpus = std::move(gpus);
+        }
+
+        if (runs(COLLECTOR_SYSTEM)) {
+            { PerfTimer t(PERF_UPTIME); s.uptime = getUptime(); }
+            { PerfTimer t(PERF_FD_COUNT); s.fdCount = getFileDescriptorCount(); }
+            // Monitor's own footprint
+            double selfCpu = prevSelfCpu;
+            getSelfUsage(selfCpu, s.selfRssKB);
+            s.selfCpuPercent = now > selfAt ? (float)((selfCpu - prevSelfCpu) / (now - selfAt) * 100.0) : 0;
+            prevSelfCpu = selfCpu;
+            selfAt = now;
+        }
+
+        if (runs(COLLECTOR_SOCKETS)) {
+            PerfTimer t(PERF_CONNECTIONS);
+            s.sockets = getSocketStats(!socketSummary);
+            s.netConnections = s.sockets.tcpTotal;
+        }
+        if (runs(COLLECTOR_MOUNTS)) {
+            PerfTimer t(PERF_DISK_PARTITIONS);
+            auto partitions = std::make_shared<std::vector<DiskInfo>>();
+            fsUsage.collect(*partitions);
+            s.diskPartitions = std::move(partitions);
+        }
+        if (runs(COLLECTOR_BATTERY)) { PerfTimer t(PERF_BATTERY); s.battery = getBatteryInfo(); }
+
+        publish(next);
+        prev = next;
+    }
+}
+
+// ==================== SERIALIZATION ====================
+// Both encoders append to a caller-owned buffer so a long-running stream (or the
+// daemon's per-tick response cache) reuses one allocation.
+
+static void appendf(std::string& out, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+static void appendf(std::string& out, const char* fmt, ...) {
+    char tmp[256];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(tmp, sizeof(tmp), fmt, ap);
+    va_end(ap);
+    if (n > 0) out.append(tmp, std::min(n, (int)sizeof(tmp) - 1));
+}
+
+static void appendJsonString(std::string& out, const std::string& str) {
+    out += '"';
+    for (unsigned char c : str) {
+        if (c == '"' || c == '\\') { out += '\\'; out += (char)c; }
+        else if (c < 0x20) appendf(out, "\\u%04x", c);
+        else out += (char)c;
+    }
+    out += '"';
+}
+
+// One NDJSON line (including the trailing newline) per snapshot.
+void appendSnapshotJson(std::string& out, const MetricsSnapshot& m) {
+    const MemoryDetail& mem = m.memDetail;
+    appendf(out, "{\"seq\":%llu,\"ts\":%.6f,\"collected\":[", m.sequence, m.timestamp);
+    // Sections of collectors missing here are carried over from an earlier line.
+    bool firstCollector = true;
+    for (int id = 0; id < COLLECTOR_COUNT; id++) {
+        if (!m.ran((CollectorId)id)) continue;
+        appendf(out, "%s\"%s\"", firstCollector ? "" : ",", collectorSpecs[id].name);
+        firstCollector = false;
+    }
+    out += "],";
+    appendf(out, "\"cpu\":{\"usage\":%.2f,\"temp\":%.1f,\"freq_mhz\":%.0f,\"iowait\":%.2f,",
+            m.cpuUsage * 100, m.cpuTemp, m.cpuFreq, m.ioWaitPct);
+    appendf(out, "\"load\":[%.2f,%.2f,%.2f],\"ctxt_per_sec\":%.0f,\"intr_per_sec\":%.0f,\"cores\":[",
+            m.loadAvg1, m.loadAvg5, m.loadAvg15, m.ctxtPerSec, m.intrPerSec);
+    for (size_t i = 0; i < m.perCoreUsage->size(); i++) appendf(out, "%s%.1f", i ? "," : "", (*m.perCoreUsage)[i]);
+    out += ']';
+    if (!m.coreSched->empty()) {
+        // Run-queue delay per core, parallel to "cores"
+        out += ",\"rq_delay_ms_s\":[";
+        for (size_t i = 0; i < m.coreSched->size(); i++) appendf(out, "%s%.2f", i ? "," : "", (*m.coreSched)[i].delayMsPerSec);
+        out += "],\"rq_avg_delay_ms\":[";
+        for (size_t i = 0; i < m.coreSched->size(); i++) appendf(out, "%s%.3f", i ? "," : "", (*m.coreSched)[i].avgDelayMs);
+        out += "],\"timeslices_s\":[";
+        for (size_t i = 0; i < m.coreSched->size(); i++) appendf(out, "%s%.0f", i ? "," : "", (*m.coreSched)[i].timeslicesPerSec);
+        out += ']';
+    }
+    appendf(out, "},\"mem\":{\"total_kb\":%lld,\"available_kb\":%lld,\"free_kb\":%lld,\"buffers_kb\":%lld,\"cached_kb\":%lld,",
+            mem.totalKB, mem.availableKB, mem.freeKB, mem.buffersKB, mem.cachedKB + mem.sreclaimableKB);
+    appendf(out, "\"dirty_kb\":%lld,\"swap_total_kb\":%lld,\"swap_free_kb\":%lld},",
+            mem.dirtyKB, mem.swapTotalKB, mem.swapFreeKB);
+    appendf(out, "\"net\":{\"rx_bps\":%.0f,\"tx_bps\":%.0f,\"tcp_connections\":%d,",
+            m.downSpeed, m.upSpeed, m.netConnections);
+    out += "\"interfaces\":[";
+    for (size_t i = 0; i < m.interfaces->size(); i++) {
+        const NetInterfaceInfo& n = (*m.interfaces)[i];
+        out += i ? ",{\"name\":" : "{\"name\":";
+        appendJsonString(out, n.name);
+        appendf(out, ",\"physical\":%s,\"up\":%s,\"rx_bps\":%.0f,\"tx_bps\":%.0f,\"rx_pps\":%.0f,\"tx_pps\":%.0f,",
+                n.physical ? "true" : "false", n.up ? "true" : "false",
+                n.rxBytesPerSec, n.txBytesPerSec, n.rxPacketsPerSec, n.txPacketsPerSec);
+        appendf(out, "\"rx_drop\":%lld,\"tx_drop\":%lld,\"rx_err\":%lld,\"tx_err\":%lld}",
+                n.rxDropped, n.txDropped, n.rxErrors, n.txErrors);
+    }
+    out += "],";
+    const SocketStats& so = m.sockets;
+    appendf(out, "\"sockets\":{\"per_state\":%s,\"tcp\":{", so.perState ? "true" : "false");
+    bool firstState = true;
+    for (int st = 1; st < SocketStats::TcpStates; st++) {
+        if (!so.perState && st != SocketStats::TcpTimeWait) continue;
+        out += firstState ? "\"" : ",\"";
+        for (const char* c = tcpStateName(st); *c; c++) out += (char)tolower(*c);
+        appendf(out, "\":%d", so.tcp[st]);
+        firstState = false;
+    }
+    appendf(out, "},\"udp\":%d,\"unix\":", so.udp);
+    if (so.unixSockets < 0) out += "null";
+    else appendf(out, "%d", so.unixSockets);
+    out += "}},";
+    appendf(out, "\"disk\":{\"read_bps\":%.0f,\"write_bps\":%.0f,\"devices\":[", m.diskReadSpeed, m.diskWriteSpeed);
+    for (size_t i = 0; i < m.diskDevices->size(); i++) {
+        const DiskDeviceInfo& d = (*m.diskDevices)[i];
+        out += i ? ",{\"name\":" : "{\"name\":";
+        appendJsonString(out, d.name);
+        appendf(out, ",\"physical\":%s,\"r_s\":%.1f,\"w_s\":%.1f,\"read_bps\":%.0f,\"write_bps\":%.0f,\"d_s\":%.1f,\"f_s\":%.1f,",
+                d.physical ? "true" : "false", d.readsPerSec, d.writesPerSec, d.readBytesPerSec, d.writeBytesPerSec,
+                d.discardsPerSec, d.flushesPerSec);
+        appendf(out, "\"r_await_ms\":%.2f,\"w_await_ms\":%.2f,\"await_ms\":%.2f,\"aqu_sz\":%.2f,\"util\":%.1f,\"in_flight\":%lld}",
+                d.readAwaitMs, d.writeAwaitMs, d.awaitMs, d.queueDepth, d.utilPercent, d.inFlight);
+    }
+    out += "],\"partitions\":[";
+    for (size_t i = 0; i < m.diskPartitions->size(); i++) {
+        const DiskInfo& d = (*m.diskPartitions)[i];
+        out += i ? ",{\"mount\":" : "{\"mount\":";
+        appendJsonString(out, d.name);
+        out += ",\"fs\":";
+        appendJsonString(out, d.fsType);
+        appendf(out, ",\"total_gb\":%.2f,\"used_gb\":%.2f,\"unresponsive\":%s}", d.totalGB, d.usedGB,
+                d.unresponsive ? "true" : "false");
+    }
+    out += "]},";
+    out += "\"gpus\":[";
+    for (size_t i = 0; i < m.gpus->size(); i++) {
+        const GPUInfo& g = (*m.gpus)[i];
+        appendf(out, "%s{\"index\":%d,\"name\":", i ? "," : "", g.index);
+        appendJsonString(out, g.name);
+        appendf(out, ",\"usage\":%d,\"temp\":%d,\"mem_used_mb\":%d,\"mem_total_mb\":%d,\"fan\":%d,\"power_w\":%d}",
+                g.usagePercent, g.temp, g.memUsedMB, g.memTotalMB, g.fanSpeed, g.powerDraw);
+    }
+    out += "],";
+    if (m.battery.available) {
+        appendf(out, "\"battery\":{\"percent\":%d,\"charging\":%s,\"power_w\":%.2f},",
+                m.battery.percent, m.battery.charging ? "true" : "false", m.battery.powerWatts);
+    }
+    appendf(out, "\"procs\":{\"count\":%d,\"threads\":%d,\"fds\":%d,\"top\":[",
+            m.processCount, m.threadCount, m.fdCount);
+    auto appendProcesses = [&out](const std::vector<ProcessInfo>& procs) {
+        for (size_t i = 0; i < procs.size(); i++) {
+            const ProcessInfo& p = procs[i];
+            appendf(out, "%s{\"pid\":%d,\"name\":", i ? "," : "", p.pid);
+            appendJsonString(out, p.name);
+            appendf(out, ",\"state\":\"%c\",\"cpu\":%.2f,\"mem_mb\":%.1f,\"threads\":%d",
+                    p.state ? p.state : '?', p.cpuPercent, p.memMB, p.threadCount);
+            if (p.memSampled)
+                appendf(out, ",\"pss_mb\":%.1f,\"uss_mb\":%.1f,\"swap_mb\":%.1f,\"mem_age\":%.1f", p.pssMB, p.ussMB, p.swapMB, p.memAge);
+            if (p.ioSampled) {
+                appendf(out, ",\"io\":{\"read_bps\":%.0f,\"write_bps\":%.0f,\"cancelled_write_bps\":%.0f,\"syscr_s\":%.1f,\"syscw_s\":%.1f}",
+                        p.io.readBytesPerSec, p.io.writeBytesPerSec, p.io.cancelledWriteBytesPerSec, p.io.syscrPerSec, p.io.syscwPerSec);
+            }
+            if (p.schedSampled) {
+                appendf(out, ",\"sched\":{\"rq_delay_ms_s\":%.2f,\"rq_avg_delay_ms\":%.3f,\"timeslices_s\":%.0f}",
+                        p.sched.delayMsPerSec, p.sched.avgDelayMs, p.sched.timeslicesPerSec);
+            }
+            out += '}';
+        }
+    };
+    appendProcesses(*m.topProcesses);
+    out += "],\"top_io\":[";
+    appendProcesses(*m.topIoProcesses);
+    out += "],\"top_mem\":[";
+    appendProcesses(*m.topMemProcesses);
+    out += "]},";
+    out += "\"cgroups\":[";
+    for (size_t i = 0; i < m.cgroups->size(); i++) {
+        const CgroupInfo& c = (*m.cgroups)[i];
+        out += i ? ",{\"path\":" : "{\"path\":";
+        appendJsonString(out, c.path);
+        appendf(out, ",\"depth\":%d,\"populated\":%s,\"cpu\":%.2f,\"throttled\":%.2f,\"io_read_bps\":%.0f,\"io_write_bps\":%.0f,\"io_ops\":%.1f",
+                c.depth, c.populated ? "true" : "false", c.cpuPercent, c.throttledPercent, c.ioReadBytesPerSec,
+                c.ioWriteBytesPerSec, c.ioOpsPerSec);
+        // Absent interface files (controller not enabled) are left out.
+        if (c.memoryBytes >= 0) appendf(out, ",\"mem_bytes\":%lld", c.memoryBytes);
+        if (c.anonBytes >= 0) appendf(out, ",\"anon_bytes\":%lld", c.anonBytes);
+        if (c.fileBytes >= 0) appendf(out, ",\"file_bytes\":%lld", c.fileBytes);
+        if (c.pids >= 0) appendf(out, ",\"pids\":%lld", c.pids);
+        if (c.cpuPressure >= 0) appendf(out, ",\"cpu_some\":%.2f", c.cpuPressure);
+        if (c.memoryPressure >= 0) appendf(out, ",\"memory_some\":%.2f", c.memoryPressure);
+        if (c.ioPressure >= 0) appendf(out, ",\"io_some\":%.2f", c.ioPressure);
+        out += '}';
+    }
+    out += "],";
+    // Resources without PSI are left out; "recent" is the share of the last interval.
+    out += "\"pressure\":{";
+    bool firstResource = true;
+    const std::pair<const char*, const PressureInfo*> resources[3] = {
+        {"cpu", &m.pressure.cpu}, {"memory", &m.pressure.memory}, {"io", &m.pressure.io},
+    };
+    for (const auto& r : resources) {
+        const PressureInfo& p = *r.second;
+        if (!p.available) continue;
+        appendf(out, "%s\"%s\":{", firstResource ? "" : ",", r.first);
+        for (int full = 0; full < 2; full++) {
+            const PressureLine& l = full ? p.full : p.some;
+            appendf(out, "%s\"%s\":{\"avg10\":%.2f,\"avg60\":%.2f,\"avg300\":%.2f,\"total_us\":%lld,\"recent\":%.2f}",
+                    full ? "," : "", full ? "full" : "some", l.avg10, l.avg60, l.avg300, l.totalUsec,
+                    full ? p.fullRecentPercent : p.someRecentPercent);
+        }
+        out += '}';
+        firstResource = false;
+    }
+    out += "},\"psi_triggers\":[";
+    for (size_t i = 0; i < m.psiTriggers->size(); i++) {
+        const PsiTriggerInfo& t = (*m.psiTriggers)[i];
+        out += i ? ",{\"spec\":" : "{\"spec\":";
+        appendJsonString(out, t.spec);
+        appendf(out, ",\"events\":%llu,\"last\":%.3f,\"recent\":[", t.events, t.lastEvent);
+        for (size_t j = 0; j < t.recent.size(); j++) appendf(out, "%s%.3f", j ? "," : "", t.recent[j]);
+        out += ']';
+        if (!t.error.empty()) {
+            out += ",\"error\":";
+            appendJsonString(out, t.error);
+        }
+        out += '}';
+    }
+    out += "],";
+    appendf(out, "\"self\":{\"cpu\":%.2f,\"rss_kb\":%lld}}\n", m.selfCpuPercent, m.selfRssKB);
+}
+
+template <typename T>
+static void appendRaw(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Length-prefixed binary record, host byte order (little-endian on x86/ARM):
+//   u32 payload length, then the payload:
+//   u16 version (1), u16 collectors that ran (bit per CollectorId), u64 seq, f64 ts
+//   f32 cpu%, temp, freq MHz, iowait%, load1, load5, load15, ctxt/s, intr/s
+//   u16 core count, f32 per-core %[count]
+//   i64 mem total, available, free, buffers, cached, swap total, swap free (kB)
+//   f64 rx B/s, tx B/s, disk read B/s, disk write B/s
+//   i32 processes, threads, fds, tcp connections
+//   u16 top count, then per process: i32 pid, f32 cpu%, f32 mem MB, i32 threads,
+//       u8 state, u8 name length, name bytes
+void appendSnapshotBinary(std::string& out, const MetricsSnapshot& m) {
+    size_t start = out.size();
+    appendRaw<uint32_t>(out, 0); // patched below
+    appendRaw<uint16_t>(out, 1);
+    appendRaw<uint16_t>(out, (uint16_t)m.collected);
+    appendRaw<uint64_t>(out, m.sequence);
+    appendRaw<double>(out, m.timestamp);
+    for (float f : {m.cpuUsage * 100, m.cpuTemp, m.cpuFreq, m.ioWaitPct, m.loadAvg1, m.loadAvg5, m.loadAvg15, m.ctxtPerSec, m.intrPerSec})
+        appendRaw<float>(out, f);
+    appendRaw<uint16_t>(out, (uint16_t)m.perCoreUsage->size());
+    for (float f : *m.perCoreUsage) appendRaw<float>(out, f);
+    const MemoryDetail& mem = m.memDetail;
+    for (long long kb : {mem.totalKB, mem.availableKB, mem.freeKB, mem.buffersKB, mem.cachedKB + mem.sreclaimableKB, mem.swapTotalKB, mem.swapFreeKB})
+        appendRaw<int64_t>(out, kb);
+    for (double d : {m.downSpeed, m.upSpeed, m.diskReadSpeed, m.diskWriteSpeed})
+        appendRaw<double>(out, d);
+    for (int n : {m.processCount, m.threadCount, m.fdCount, m.netConnections})
+        appendRaw<int32_t>(out, n);
+    appendRaw<uint16_t>(out, (uint16_t)m.topProcesses->size());
+    for (const ProcessInfo& p : *m.topProcesses) {
+        appendRaw<int32_t>(out, p.pid);
+        appendRaw<float>(out, p.cpuPercent);
+        appendRaw<float>(out, p.memMB);
+        appendRaw<int32_t>(out, p.threadCount);
+        appendRaw<uint8_t>(out, (uint8_t)p.state);
+        size_t nameLen = std::min(p.name.size(), (size_t)255);
+        appendRaw<uint8_t>(out, (uint8_t)nameLen);
+        out.append(p.name, 0, nameLen);
+    }
+    uint32_t payload = (uint32_t)(out.size() - start - sizeof(uint32_t));
+    memcpy(&out[start], &payload, sizeof(payload));
+}
@@ -0,0 +1,1053 @@
+// CekyMonitor - Linux data collection
+// Collectors, the background sampler and snapshot encoders shared by the GUI/headless
+// monitor (src/main.cpp) and the metrics daemon (src/server.cpp).
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/types.h>
+
+// ==================== DATA STRUCTURES ====================
+struct CPUStats { long long user, nice, system, idle, iowait, irq, softirq, steal; };
+struct NetStats { long long rxBytes, txBytes; };
+struct DiskStats { long long readBytes, writeBytes; };
+struct DiskInfo { std::string name; std::string fsType; float totalGB, usedGB, usagePercent; bool unresponsive; };
+struct GPUInfo { std::string name; int temp; int usagePercent; int memUsedMB, memTotalMB; int fanSpeed; int powerDraw; bool available; int index; };
+struct BatteryInfo { int percent; bool charging; bool available; float powerWatts; int estimatedMinutes; };
+struct DiskIOInfo { double readBytesPerSec, writeBytesPerSec; long long totalRead, totalWrite; };
+
+struct NetInterfaceInfo {
+    std::string name;
+    bool physical, up;
+    double rxBytesPerSec, txBytesPerSec, rxPacketsPerSec, txPacketsPerSec;
+    long long rxDropped, txDropped, rxErrors, txErrors; // since the interface was created
+};
+
+// iostat -x style figures for one whole disk over the last interval.
+struct DiskDeviceInfo {
+    std::string name;
+    bool physical;
+    double readsPerSec, writesPerSec, readBytesPerSec, writeBytesPerSec;
+    double discardsPerSec, flushesPerSec;
+    float readAwaitMs, writeAwaitMs, awaitMs; // average time per completed request
+    float queueDepth;  // aqu-sz: average requests queued or in service
+    float utilPercent; // share of the interval with at least one request in service
+    long long inFlight;
+};
+
+// Per-second deltas of /proc/[pid]/io, averaged since the counters were last read.
+struct ProcIoRates {
+    float readBytesPerSec, writeBytesPerSec; // storage layer (read_bytes/write_bytes)
+    float cancelledWriteBytesPerSec;         // dirty pages truncated before writeback
+    float syscrPerSec, syscwPerSec;          // read/write-family syscalls
+};
+
+// Run-queue delay over an interval: how long runnable tasks waited for a CPU.
+struct SchedDelay {
+    float delayMsPerSec;    // waiting time per second, summed over tasks (1000 = one task always waiting)
+    float avgDelayMs;       // waiting time per timeslice, i.e. the typical wakeup-to-run latency
+    float timeslicesPerSec;
+};
+
+struct ProcessInfo {
+    std::string name;
+    int pid;
+    long long starttime;
+    float cpuPercent;
+    float memMB;
+    int threadCount;
+    char state;
+    bool ioSampled; // io holds this tick's rates; false when /proc/[pid]/io was skipped or unreadable
+    ProcIoRates io;
+    bool memSampled;             // smaps_rollup has been read; the three below are valid
+    float pssMB, ussMB, swapMB;  // as of memAge seconds ago
+    float memAge;
+    bool schedSampled; // sched holds this tick's run-queue delay
+    SchedDelay sched;
+};
+
+// One line of a PSI file: "some avg10=0.12 avg60=0.05 avg300=0.01 total=123456".
+struct PressureLine { float avg10, avg60, avg300; long long totalUsec; };
+
+// /proc/pressure/<resource>. "some": at least one task was stalled on the resource;
+// "full": every non-idle task was stalled at once. The kernel's averages decay
+// exponentially, so a short episode only shows at its real height in the
+// recent*Percent figures, taken from the total delta over the last interval.
+struct PressureInfo {
+    bool available;
+    PressureLine some, full; // cpu "full" reads zero before 5.13
+    float someRecentPercent, fullRecentPercent;
+};
+struct SystemPressure { PressureInfo cpu, memory, io; };
+
+// A registered PSI trigger and the stall episodes the kernel reported for it.
+struct PsiTriggerInfo {
+    std::string spec;           // normalised, e.g. "memory some 150ms in 1s"
+    std::string error;          // set once the trigger stopped working
+    unsigned long long events;
+    double lastEvent;           // monotonicSeconds(), 0 before the first event
+    std::vector<double> recent; // latest event times, oldest first
+};
+
+// One cgroup v2 group. CgroupCollector emits them depth-first, so a parent always
+// precedes its children. -1 marks a value whose interface file is absent (the
+// controller is not enabled for the group, or it is the root).
+struct CgroupInfo {
+    std::string name; // last path component, "/" for the root
+    std::string path; // relative to the cgroup2 mount, "/" for the root
+    int depth;
+    bool populated;         // processes live somewhere in its subtree (cgroup.events)
+    float cpuPercent;       // share of all CPUs, like ProcessInfo::cpuPercent
+    float throttledPercent; // share of the interval spent throttled by cpu.max
+    long long memoryBytes, anonBytes, fileBytes;
+    float ioReadBytesPerSec, ioWriteBytesPerSec, ioOpsPerSec;
+    long long pids;
+    float cpuPressure, memoryPressure, ioPressure; // "some" stall share of the interval, -1 without PSI
+};
+
+struct SystemInfo {
+    std::string distroName, distroVersion, kernelVersion;
+    std::string hostname, username, architecture;
+    int logicalCores, physicalCores;
+    float totalRamGB;
+};
+
+struct MemoryDetail {
+    long long totalKB, availableKB, freeKB;
+    long long buffersKB, cachedKB, sreclaimableKB;
+    long long dirtyKB, writebackKB;
+    long long swapTotalKB, swapFreeKB, swapCachedKB;
+    long long sharedKB, activeKB, inactiveKB;
+};
+
+// ==================== HISTORY ====================
+// Fixed-capacity ring of samples, pre-filled with zeros like the old vectors.
+// push() is O(1); PlotLines reads the storage in place with offset() as its
+// values_offset, so plotting never copies or shifts the series.
+class MetricHistory {
+public:
+    explicit MetricHistory(int capacity = 120) : values(capacity > 0 ? capacity : 1, 0.0f) {}
+
+    void push(float v) {
+        values[head] = v;
+        head = (head + 1) % (int)values.size();
+    }
+
+    float latest() const { return values[(head + values.size() - 1) % values.size()]; }
+    const float* data() const { return values.data(); }
+    int size() const { return (int)values.size(); }
+    int offset() const { return head; } // index of the oldest sample
+
+    // Sample i counted from the oldest one.
+    float at(int i) const { return values[(head + i) % values.size()]; }
+
+    // Changes the capacity, keeping the most recent samples.
+    void resize(int capacity) {
+        if (capacity <= 0 || capacity == size()) return;
+        std::vector<float> next(capacity, 0.0f);
+        int keep = std::min(capacity, size());
+        for (int i = 0; i < keep; i++) next[capacity - keep + i] = at(size() - keep + i);
+        values.swap(next);
+        head = 0;
+    }
+
+private:
+    std::vector<float> values;
+    int head = 0;
+};
+
+// ==================== CACHED SOURCES ====================
+// Fixed /proc and /sys files are opened once and re-read with pread() at offset 0,
+// which makes the kernel regenerate their contents. In steady state a sample costs
+// one syscall per source and no allocations.
+struct ProcSource {
+    std::string key;  // canonical path, e.g. "/proc/stat"
+    std::string path; // key mapped onto the current host roots
+    int fd = -1;
+    std::vector<char> buf;
+    size_t len = 0;
+    const char* begin() const { return buf.data(); }
+    const char* end() const { return buf.data() + len; }
+};
+
+// Registry entry for path, created on first use. Not thread-safe: only the sampler
+// thread may use it.
+ProcSource& procSource(const std::string& path);
+
+// procfs/sysfs mount points ("/proc" and "/sys" by default). Collectors always name
+// canonical paths; hostPath() maps them onto the roots, so fixture trees (see
+// bench/) or a host /proc bind-mounted into a container can be read instead.
+// Changing the roots re-targets every cached source; call it while no sampler runs.
+void setHostRoots(const std::string& procRoot, const std::string& sysRoot);
+std::string hostPath(const std::string& path);
+bool readSource(ProcSource& src);
+bool readSourceLL(ProcSource& src, long long& value);
+double monotonicSeconds();
+long long monotonicNanos();
+
+// ==================== SELF PROFILING ====================
+// Per-thread counters. Collectors bump syscalls around their own I/O (one per libc
+// call for helpers such as readdir/popen that may issue several); allocations is
+// bumped by the global operator new. Plain integers, so operator new can touch
+// them without recursing.
+struct PerfCounters { unsigned long long syscalls, allocations; };
+extern thread_local PerfCounters perfThreadCounters;
+inline void countSyscalls(int n = 1) { perfThreadCounters.syscalls += n; }
+
+// Fixed-bucket latency histogram: 4 sub-buckets per power of two of nanoseconds
+// (~19% resolution), so recording never allocates.
+struct LatencyHistogram {
+    static const int Buckets = 128;
+    unsigned long long counts[Buckets];
+    unsigned long long samples, syscalls, allocations;
+    long long lastNs, maxNs;
+    double totalNs;
+
+    void record(long long ns, const PerfCounters& delta);
+    long long percentile(double p) const; // bucket upper bound, capped at maxNs
+};
+
+// Everything that is timed. Collectors run on the sampler thread, FRAME_* on the UI thread.
+enum PerfId {
+    PERF_PROC_STAT, PERF_CPU_SENSORS, PERF_MEMORY, PERF_NETWORK, PERF_DISK_STATS,
+    PERF_PROC_WALK, PERF_PROC_IO, PERF_PROC_SMAPS, PERF_PROC_SCHED, PERF_TOP_PROCESSES, PERF_CGROUPS, PERF_PRESSURE, PERF_UPTIME,
+    PERF_GPU, PERF_BATTERY, PERF_DISK_PARTITIONS, PERF_FD_COUNT, PERF_CONNECTIONS,
+    PERF_SAMPLER_TICK,
+    PERF_FRAME_BUILD, PERF_FRAME_DRAW, PERF_FRAME_PRESENT,
+    PERF_COUNT
+};
+const char* perfName(PerfId id);
+
+void perfRecord(PerfId id, long long ns, const PerfCounters& delta);
+// Copies all histograms (indexed by PerfId) under the registry lock.
+void perfSnapshot(std::vector<LatencyHistogram>& out);
+
+// Times its scope and attributes the calling thread's syscall/allocation deltas.
+class PerfTimer {
+public:
+    explicit PerfTimer(PerfId id) : id(id), start(monotonicNanos()), counters(perfThreadCounters) {}
+    ~PerfTimer() {
+        long long ns = monotonicNanos() - start;
+        PerfCounters delta = { perfThreadCounters.syscalls - counters.syscalls,
+                               perfThreadCounters.allocations - counters.allocations };
+        perfRecord(id, ns, delta);
+    }
+    PerfTimer(const PerfTimer&) = delete;
+    PerfTimer& operator=(const PerfTimer&) = delete;
+
+private:
+    PerfId id;
+    long long start;
+    PerfCounters counters;
+};
+
+// ==================== CPU FUNCTIONS ====================
+// Everything the CPU collectors need from /proc/stat, taken from a single read so
+// aggregate, per-core and counter values all describe the same instant.
+struct ProcStatSnapshot {
+    CPUStats total;
+    std::vector<CPUStats> cores;
+    long long ctxt, intr, softirq;
+    int procsRunning, procsBlocked;
+    double timestamp; // monotonicSeconds() at read time
+};
+
+bool readProcStatSnapshot(ProcStatSnapshot& snap);
+CPUStats readCPUStats(const ProcStatSnapshot& snap);
+const std::vector<CPUStats>& readPerCoreCPUStats(const ProcStatSnapshot& snap);
+void getContextSwitchesAndInterrupts(const ProcStatSnapshot& snap, long long& ctxt, long long& intr);
+float calcCPUUsage(const CPUStats& oldS, const CPUStats& newS);
+float getCPUTemp();
+float getCPUFrequency();
+float getCPUMaxFrequency();
+int getCPUCoreCount();
+int getPhysicalCoreCount();
+std::string getCPUModel();
+void getLoadAverages(float& l1, float& l5, float& l15);
+// Per-CPU counters from /proc/schedstat, in nanoseconds since boot: time spent
+// running, time tasks spent waiting on the CPU's run queue, and timeslices run.
+struct CpuSchedStat { int cpu; long long runNs, waitNs, timeslices; };
+// Online CPUs in order, like readPerCoreCPUStats(). False without CONFIG_SCHEDSTATS.
+bool readSchedStat(std::vector<CpuSchedStat>& out);
+
+// ==================== MEMORY / NETWORK / DISK ====================
+MemoryDetail getMemoryDetail();
+
+// Counters of one network interface since it was created.
+struct NetInterfaceStats {
+    std::string name;
+    int ifindex; // 0 when read from /proc/net/dev
+    bool physical, up, loopback;
+    long long rxBytes, txBytes, rxPackets, txPackets;
+    long long rxDropped, txDropped, rxErrors, txErrors;
+};
+// One RTM_GETLINK dump (rtnl_link_stats64 per link), or /proc/net/dev when
+// rtnetlink is unavailable or a fixture root is set. Physical means backed by a
+// device in sysfs and not a veth/bond/vlan/bridge/tun... link. Reuses out's
+// strings, so steady state does not allocate.
+bool readNetInterfaces(std::vector<NetInterfaceStats>& out);
+// Totals that count each packet once: physical interfaces only (a bond, its
+// VLANs and its slaves would otherwise all be summed), or every non-loopback
+// interface when there is no physical one (e.g. a container's veth).
+NetStats sumNetInterfaces(const std::vector<NetInterfaceStats>& ifaces);
+NetStats readNetStats();
+
+// Socket counts for the sampler's network namespace. tcp[] is indexed by kernel
+// TCP state (1 = ESTABLISHED ... 11 = CLOSING, see tcpStateName()).
+struct SocketStats {
+    static const int TcpStates = 12;
+    static const int TcpTimeWait = 6;
+    int tcp[TcpStates];
+    int tcpTotal, udp;
+    int unixSockets; // -1 in summary mode
+    bool perState;   // false: sockstat summary, only tcp[TcpTimeWait] is known
+};
+const char* tcpStateName(int state);
+// perState: full breakdown from NETLINK_SOCK_DIAG binary dumps, falling back to
+// parsing /proc/net/{tcp,tcp6,udp,udp6,unix} per protocol when sock_diag is
+// unavailable or a fixture root is in use. Otherwise the /proc/net/sockstat
+// summary, which costs two small reads however many sockets exist.
+SocketStats getSocketStats(bool perState);
+int getNetworkConnectionCount(); // TCP sockets in any state, from the summary
+
+// Cumulative /proc/diskstats counters of one block device, every field (see the
+// kernel's iostats.rst); discard and flush counters stay 0 on kernels that
+// predate them. Ticks are milliseconds.
+struct BlockDeviceStats {
+    std::string name;
+    bool wholeDisk; // has a /sys/block entry; partitions only appear below their disk
+    bool physical;  // whole disk backed by a device (not dm-*, md*, loop*, zram*...)
+    long long reads, readsMerged, sectorsRead, readTicks;
+    long long writes, writesMerged, sectorsWritten, writeTicks;
+    long long inFlight, ioTicks, timeInQueue;
+    long long discards, discardsMerged, sectorsDiscarded, discardTicks;
+    long long flushes, flushTicks;
+};
+// One pass over /proc/diskstats. Without /sys/block (some containers, old
+// fixtures) whole disks are guessed from the name. Reuses out's strings.
+bool readBlockDevices(std::vector<BlockDeviceStats>& out);
+// Bytes moved by physical whole disks, so partitions, dm/md stacks and loop
+// devices do not count the same I/O again.
+DiskStats sumBlockDevices(const std::vector<BlockDeviceStats>& devices);
+DiskStats readDiskStats();
+
+// Usage of the mounted filesystems worth showing. statvfs() runs on a few detached
+// worker threads, so a dead NFS/CIFS/FUSE server cannot stall the sampler:
+// collect() waits at most WaitBudget for this round's answers, and a mount whose
+// call has been running for Timeout is reported as unresponsive (with its last
+// known figures) and not queried again until that call comes back. Stuck calls
+// are replaced by extra workers and slow mounts queue last, so healthy mounts
+// keep being answered behind a dead server. The mount
+// table is only re-parsed when poll() on /proc/self/mountinfo reports a change.
+class FsUsageCollector {
+public:
+    FsUsageCollector() = default;
+    ~FsUsageCollector();
+    FsUsageCollector(const FsUsageCollector&) = delete;
+    FsUsageCollector& operator=(const FsUsageCollector&) = delete;
+
+    void collect(std::vector<DiskInfo>& out);
+
+private:
+    struct Mount { std::string mountPoint, fsType; };
+    struct Shared; // job queue and results; outlives this object while a worker is stuck
+    void refreshMounts();
+    static void workerLoop(std::shared_ptr<Shared> shared);
+
+    static const int MaxWorkers = 4;             // statvfs() calls in parallel
+    static const int MaxStuckWorkers = 8;        // extra threads that hung mounts may pin
+    static constexpr double Timeout = 2.0;       // seconds before a mount is unresponsive
+    static constexpr double WaitBudget = 0.1;    // seconds collect() waits for results
+
+    std::vector<Mount> mounts;
+    std::shared_ptr<Shared> shared;
+    unsigned mountsGeneration = ~0u; // hostRootsGeneration the table was read under
+};
+
+// ==================== GPU / BATTERY ====================
+// NVIDIA GPUs come from one long-lived `nvidia-smi --query-gpu=... --loop-ms=N`
+// child whose CSV output is parsed incrementally from a non-blocking pipe, so a
+// sample costs a read() instead of a fork+exec. Without a working nvidia-smi, a
+// single AMD/Intel GPU is read from sysfs. Owned by the sampler thread.
+class GpuCollector {
+public:
+    explicit GpuCollector(int periodMs) : periodMs(periodMs) {}
+    ~GpuCollector();
+    GpuCollector(const GpuCollector&) = delete;
+    GpuCollector& operator=(const GpuCollector&) = delete;
+
+    // Latest reading of every GPU, ordered by index. Empty if there is none.
+    void poll(std::vector<GPUInfo>& gpus);
+    // Restarts a running stream with the new --loop-ms on the next poll().
+    void setInterval(int periodMs);
+
+private:
+    bool spawn();
+    void reap();
+    void parseLine(const char* p, const char* end);
+
+    static constexpr double RestartDelay = 10.0; // after a stream that had worked dies
+
+    int periodMs;
+    pid_t child = -1;
+    int fd = -1;
+    std::string pending;         // bytes after the last complete line
+    std::vector<GPUInfo> latest; // indexed by GPU index
+    std::vector<std::string> rawNames; // untruncated name field, same indexing
+    bool producedData = false;
+    bool disabled = false;       // nvidia-smi missing or never produced a line
+    double restartAt = 0;
+};
+
+// Executable used by GpuCollector ("nvidia-smi" from PATH by default). Pointing it
+// at a stub script exercises the streaming path on machines without a GPU.
+void setNvidiaSmiCommand(const std::string& command);
+
+BatteryInfo getBatteryInfo();
+
+// ==================== PROCESS FUNCTIONS ====================
+// Everything the monitor needs from one /proc/[pid]/stat read. Fixed-size, so a
+// tick's worth of records lives in one reused vector.
+struct ProcRecord {
+    int pid, ppid;
+    char state;
+    char comm[16]; // TASK_COMM_LEN, NUL-terminated
+    long long utime, stime;
+    long long minflt, majflt;
+    long long starttime, rss; // starttime in clock ticks since boot, rss in pages
+    int numThreads, processor;
+};
+
+// Previous-tick CPU jiffies keyed by (pid, starttime), so a recycled pid never
+// inherits a dead process's counters. Open addressing with linear probing over a
+// power-of-two slot array that is kept across ticks; clear() only bumps a
+// generation counter, so rebuilding the table every tick allocates nothing once
+// it has reached its working size.
+class ProcTickTable {
+public:
+    void clear() {
+        count = 0;
+        if (++generation == 0) { // wrapped: invalidate every slot explicitly
+            for (Slot& sl : slots) sl.gen = 0;
+            generation = 1;
+        }
+    }
+
+    void insert(int pid, long long starttime, long long jiffies) {
+        if ((count + 1) * 2 > slots.size()) grow();
+        Slot& sl = probe(pid, starttime);
+        if (sl.gen != generation) count++;
+        sl = {generation, pid, starttime, jiffies};
+    }
+
+    // Returns the stored jiffies, or nullptr if the process wasn't seen last tick.
+    const long long* find(int pid, long long starttime) const {
+        if (slots.empty()) return nullptr;
+        size_t mask = slots.size() - 1;
+        for (size_t i = hash(pid, starttime) & mask;; i = (i + 1) & mask) {
+            const Slot& sl = slots[i];
+            if (sl.gen != generation) return nullptr;
+            if (sl.pid == pid && sl.starttime == starttime) return &sl.jiffies;
+        }
+    }
+
+    void rebuild(const std::vector<ProcRecord>& ticks) {
+        clear();
+        for (const auto& t : ticks) insert(t.pid, t.starttime, t.utime + t.stime);
+    }
+
+private:
+    struct Slot { unsigned gen; int pid; long long starttime; long long jiffies; };
+
+    static size_t hash(int pid, long long starttime) {
+        unsigned long long h = (unsigned long long)(unsigned)pid * 0x9E3779B97F4A7C15ULL;
+        h ^= (unsigned long long)starttime + 0x632BE59BD9B4E019ULL + (h << 6) + (h >> 2);
+        return (size_t)(h ^ (h >> 32));
+    }
+
+    Slot& probe(int pid, long long starttime) {
+        size_t mask = slots.size() - 1;
+        for (size_t i = hash(pid, starttime) & mask;; i = (i + 1) & mask) {
+            Slot& sl = slots[i];
+            if (sl.gen != generation || (sl.pid == pid && sl.starttime == starttime)) return sl;
+        }
+    }
+
+    void grow() {
+        std::vector<Slot> old;
+        old.swap(slots);
+        slots.assign(old.empty() ? 1024 : old.size() * 2, Slot{0, 0, 0, 0});
+        unsigned oldGen = generation;
+        generation = 1;
+        count = 0;
+        for (const Slot& sl : old)
+            if (sl.gen == oldGen) insert(sl.pid, sl.starttime, sl.jiffies);
+    }
+
+    std::vector<Slot> slots;
+    unsigned generation = 1;
+    size_t count = 0;
+};
+
+void readAllProcTicks(std::vector<ProcRecord>& records);
+bool listProcPids(std::vector<int>& pids); // numeric proc root entries, readdir order
+
+// Parallel readAllProcTicks for hosts with tens of thousands of processes. The
+// calling thread lists the pids; it and threads-1 pool workers then read
+// contiguous slices into their own reusable slabs, which are concatenated in
+// slice order, so the result is identical to readAllProcTicks().
+class ProcWalker {
+public:
+    explicit ProcWalker(int threads);
+    ~ProcWalker();
+    ProcWalker(const ProcWalker&) = delete;
+    ProcWalker& operator=(const ProcWalker&) = delete;
+
+    void walk(std::vector<ProcRecord>& records);
+    // Reads only the given pids (e.g. a set kept by ProcEventTracker); pids that
+    // have exited are skipped.
+    void read(const std::vector<int>& pids, std::vector<ProcRecord>& records);
+    int threadCount() const { return (int)slices.size(); }
+
+    static const size_t ParallelThreshold = 2048; // pids; fewer stay on one thread
+
+private:
+    struct Slice {
+        size_t begin = 0, end = 0;
+        std::vector<ProcRecord> records;
+        unsigned long long syscalls = 0;
+    };
+    void workerLoop(int index);
+    void readSlice(Slice& slice);
+
+    std::vector<int> pids;               // walk()'s listing
+    const std::vector<int>* slicePids = nullptr;
+    std::vector<Slice> slices; // slices[0] belongs to the calling thread
+    std::vector<std::thread> workers;
+    int dirFd = -1;
+    std::mutex mutex;
+    std::condition_variable startWork, workDone;
+    unsigned long long generation = 0;
+    int pending = 0;
+    bool stopping = false;
+};
+
+// Live pid set kept up to date from the kernel proc connector (NETLINK_CONNECTOR
+// fork/exec events), so a tick rereads stat for known pids without listing
+// the proc root. Before Linux 6.6 subscribing needs CAP_NET_ADMIN; when open()
+// fails the caller keeps scanning. Only the real /proc is tracked (fixture
+// roots emit no events).
+class ProcEventTracker {
+public:
+    ProcEventTracker() = default;
+    ~ProcEventTracker();
+    ProcEventTracker(const ProcEventTracker&) = delete;
+    ProcEventTracker& operator=(const ProcEventTracker&) = delete;
+
+    bool open();
+    bool active() const { return sock >= 0; }
+    // Applies queued events and returns the sorted pid set. Falls back to a full
+    // listing when the socket overflowed and events were dropped.
+    const std::vector<int>& update();
+    // Replaces the set with the pids that were actually read. Exits are applied
+    // here rather than from EXIT events: an exited process stays in /proc as a
+    // zombie until reaped, and the scan counts it until then too.
+    void retain(const std::vector<ProcRecord>& records);
+    unsigned long long resyncCount() const { return resyncs; }
+
+private:
+    void drain();
+
+    static const size_t MaxPendingBirths = 1 << 20; // beyond this a rescan is cheaper
+
+    int sock = -1;
+    std::vector<int> pids, merged;
+    std::vector<int> born; // tgids from fork/exec events since the last update()
+    bool needResync = false;
+    bool acked = false;
+    int ackError = 0;
+    unsigned long long resyncs = 0;
+};
+
+// Per-process /proc/[pid]/io rates. Reading io for every pid would cost as much
+// as the stat walk itself, so update() only reads processes that used CPU since
+// the previous tick or were in the previous I/O top set. Other processes keep
+// their last counters, and their next rate covers the whole gap. Processes that
+// cannot be read (another user's process without CAP_SYS_PTRACE) are skipped.
+class ProcIoTracker {
+public:
+    ProcIoTracker() = default;
+    ~ProcIoTracker();
+    ProcIoTracker(const ProcIoTracker&) = delete;
+    ProcIoTracker& operator=(const ProcIoTracker&) = delete;
+
+    void update(const ProcTickTable& oldTicks, const std::vector<ProcRecord>& records, double now);
+    // This tick's rates, or nullptr if the process was not read this tick or had
+    // no earlier reading to diff against.
+    const ProcIoRates* find(int pid, long long starttime) const;
+    // Indices into update()'s records of the busiest processes by bytes, then
+    // syscalls, moved per second. Idle processes are left out.
+    const std::vector<unsigned>& topIndices() const { return top; }
+    size_t lastReadCount() const { return reads; }
+
+    static const int TopCount = 25;
+    static constexpr double ForgetAfter = 60.0; // seconds without a read before an entry is dropped
+
+private:
+    struct Counters { long long readBytes, writeBytes, cancelledWriteBytes, syscr, syscw; };
+    struct Entry {
+        long long starttime;
+        double readAt;
+        unsigned long long tick; // update() that last read it
+        Counters counters;
+        ProcIoRates rates;
+        bool hasRates;
+    };
+    struct Ranked { float bytes, syscalls; int pid; unsigned index; };
+    bool readCounters(int pid, Counters& c);
+
+    std::unordered_map<int, Entry> entries; // by pid; starttime tells a recycled pid apart
+    std::vector<int> topPids;               // previous tick's top set
+    std::vector<unsigned> top;
+    std::vector<Ranked> ranked;             // scratch, reused across ticks
+    unsigned long long tick = 0;
+    size_t reads = 0;
+    int dirFd = -1;
+    unsigned dirGeneration = ~0u;
+};
+
+// Per-process run-queue delay from /proc/[pid]/schedstat ("run ns, wait ns,
+// timeslices"). That file only covers the thread it names, so multi-threaded
+// processes are summed over /proc/[pid]/task/*/schedstat. Like ProcIoTracker,
+// update() only reads processes that used CPU since the previous tick or are
+// runnable now; one that neither ran nor waited has nothing new to report.
+class ProcSchedTracker {
+public:
+    ProcSchedTracker() = default;
+    ~ProcSchedTracker();
+    ProcSchedTracker(const ProcSchedTracker&) = delete;
+    ProcSchedTracker& operator=(const ProcSchedTracker&) = delete;
+
+    void update(const ProcTickTable& oldTicks, const std::vector<ProcRecord>& records, double now);
+    // This tick's delay, or nullptr if the process was not read this tick or had
+    // no earlier reading to diff against.
+    const SchedDelay* find(int pid, long long starttime) const;
+    size_t lastReadCount() const { return reads; } // schedstat files, all threads counted
+
+    static constexpr double ForgetAfter = 60.0; // seconds without a read before an entry is dropped
+
+private:
+    struct Counters { long long runNs, waitNs, timeslices; };
+    struct Entry {
+        long long starttime;
+        double readAt;
+        unsigned long long tick; // update() that last read it
+        Counters counters;       // summed over the threads alive at readAt
+        SchedDelay delay;
+        bool hasDelay;
+    };
+    bool readCounters(int pid, int threads, Counters& c);
+
+    std::unordered_map<int, Entry> entries; // by pid; starttime tells a recycled pid apart
+    unsigned long long tick = 0;
+    size_t reads = 0;
+    int dirFd = -1;
+    unsigned dirGeneration = ~0u;
+};
+
+// PSS, USS and swap from /proc/[pid]/smaps_rollup. The kernel walks every
+// mapping to produce it (milliseconds for a large process), so update() spends at
+// most Budget per tick: processes never read come first (largest RSS first), then
+// the rest by RSS and RSS drift since their last read, weighted by how long ago
+// that was. A process whose RSS has not moved is left alone for MinAge; anything
+// older than MaxAge jumps the queue, so small processes still refresh every so
+// often. Values are reported as of their last read.
+class ProcMemTracker {
+public:
+    struct Usage { float pssMB, ussMB, swapMB; double readAt; };
+
+    ProcMemTracker() = default;
+    ~ProcMemTracker();
+    ProcMemTracker(const ProcMemTracker&) = delete;
+    ProcMemTracker& operator=(const ProcMemTracker&) = delete;
+
+    void update(const std::vector<ProcRecord>& records, double now);
+    // Latest reading, or nullptr if the process has not been read yet.
+    const Usage* find(int pid, long long starttime) const;
+    size_t lastReadCount() const { return reads; }
+    size_t pendingCount() const { return pending; } // never read yet after the last update()
+
+    static constexpr double Budget = 0.02;     // seconds of smaps_rollup reads per update()
+    static constexpr double MinAge = 5.0;      // seconds before an unchanged RSS is worth a re-read
+    static constexpr double MaxAge = 30.0;     // seconds before a reading counts as overdue
+    static constexpr double DriftWeight = 8.0; // RSS change counts this much more than RSS
+
+private:
+    struct Entry {
+        long long starttime;
+        long long rssAtRead;     // pages, from stat when smaps_rollup was read
+        unsigned long long seen; // update() that last saw the process
+        bool denied;             // no ptrace access; not retried for this process
+        Usage usage;
+    };
+    struct Candidate { double score; unsigned index; };
+    bool readRollup(int pid, Usage& u);
+
+    std::unordered_map<int, Entry> entries; // by pid; starttime tells a recycled pid apart
+    std::vector<Candidate> candidates;      // scratch, reused across ticks
+    unsigned long long tick = 0;
+    double avgReadSeconds = 0.0005;         // running cost estimate of one read
+    size_t reads = 0, pending = 0;
+    int dirFd = -1;
+    unsigned dirGeneration = ~0u;
+};
+
+// io, mem and sched, when given, fill ProcessInfo's I/O rates, PSS/USS/swap and run-queue delay.
+std::vector<ProcessInfo> getTopProcesses(const ProcTickTable& oldTicks, const std::vector<ProcRecord>& newTicks, long long totalCpuDelta, int maxCount = 20,
+                                         const ProcIoTracker* io = nullptr, const ProcMemTracker* mem = nullptr,
+                                         const ProcSchedTracker* sched = nullptr);
+// The "Top I/O" list: io.topIndices() as ProcessInfo, busiest first.
+std::vector<ProcessInfo> getTopIoProcesses(const ProcTickTable& oldTicks, const std::vector<ProcRecord>& newTicks, long long totalCpuDelta,
+                                           const ProcIoTracker& io, const ProcMemTracker* mem = nullptr,
+                                           const ProcSchedTracker* sched = nullptr);
+// The "Memory" list: largest PSS first. Processes mem has not read yet rank by RSS.
+std::vector<ProcessInfo> getTopMemProcesses(const ProcTickTable& oldTicks, const std::vector<ProcRecord>& newTicks, long long totalCpuDelta,
+                                            const ProcMemTracker& mem, int maxCount = 20, const ProcIoTracker* io = nullptr,
+                                            const ProcSchedTracker* sched = nullptr);
+int getProcessCount(const std::vector<ProcRecord>& records);
+int getTotalThreadCount(const std::vector<ProcRecord>& records);
+
+// ==================== CGROUPS ====================
+// cgroup v2 hierarchy with per-group rates. The tree is walked once; after that an
+// inotify watch on every group directory reports created and removed children
+// (only those subtrees are walked) and cgroup.events changes. A group that is not
+// populated is read once more and then left alone until it is populated again.
+// Without inotify, or once the watch limit is hit, the tree is re-walked every
+// RewalkInterval instead. Owned by the sampler thread.
+class CgroupCollector {
+public:
+    CgroupCollector() = default;
+    ~CgroupCollector();
+    CgroupCollector(const CgroupCollector&) = delete;
+    CgroupCollector& operator=(const CgroupCollector&) = delete;
+
+    void update(std::vector<CgroupInfo>& out, double now);
+    const std::string& mountPoint() const { return root; } // empty without a cgroup2 mount
+    bool watching() const { return inotifyFd >= 0 && !watchesExhausted; }
+    unsigned long long walkCount() const { return walks; } // directories listed so far
+
+    static constexpr double RewalkInterval = 10.0; // seconds, without working watches
+
+private:
+    struct Counters {
+        long long usageUsec, throttledUsec, ioReadBytes, ioWriteBytes, ioOps;
+        long long cpuSomeUsec, memorySomeUsec, ioSomeUsec; // PSI totals, -1 if absent
+    };
+    struct Node {
+        int depth = 0;
+        int wd = -1;
+        unsigned walked = 0;     // walkGeneration that last saw the directory
+        bool populated = true;
+        bool needsRead = true;   // read this tick even though it is not populated
+        bool hasPrev = false;
+        double prevAt = 0;
+        Counters prev = {};
+        CgroupInfo info = {};
+    };
+    // '/' sorts before every other byte, so a std::map iterates depth-first.
+    struct PathLess { bool operator()(const std::string& a, const std::string& b) const; };
+    using NodeMap = std::map<std::string, Node, PathLess>;
+
+    void open();
+    void close();
+    void walk(const std::string& path, int depth);
+    void removeSubtree(const std::string& path);
+    void drainEvents();
+    void readEvents(const std::string& path, Node& node);
+    void readGroup(const std::string& path, Node& node, double now);
+    bool readFile(const std::string& path, const char* name);
+
+    std::string root;              // cgroup2 mount point, after the host roots
+    unsigned rootGeneration = ~0u; // hostRootsGeneration root was found under
+    NodeMap nodes;                 // by path relative to root ("" for the root)
+    std::unordered_map<int, std::string> watches; // inotify wd -> path
+    int inotifyFd = -1;
+    bool watchesExhausted = false;
+    bool needResync = false;
+    unsigned walkGeneration = 0;
+    unsigned long long walks = 0;
+    double lastWalk = 0;
+    int cpuCount = 1;
+    std::string filePath;          // scratch
+    std::vector<char> buf;
+    size_t len = 0;
+};
+
+// ==================== PRESSURE STALL INFORMATION ====================
+// Parses a PSI file (the /proc/pressure and cgroup *.pressure format); false
+// without a "some" line. The recent percentages are left to the caller.
+bool parsePressure(const char* p, const char* end, PressureInfo& out);
+// /proc/pressure/{cpu,memory,io}; available stays false without CONFIG_PSI or with psi=0.
+void readSystemPressure(SystemPressure& out);
+// Fills cur's recent percentages from the total deltas since prev.
+void pressureRates(const SystemPressure& prev, SystemPressure& cur, double seconds);
+
+// PSI triggers. Writing "some|full <stall us> <window us>" to a pressure file
+// arms it: poll() then reports POLLPRI each time the stall time within a window
+// crosses the threshold (at most once per window). A thread blocks in poll() on
+// every trigger, so episodes are timestamped as they happen rather than averaged
+// into the next tick. Needs Linux 5.2; windows run from 500 ms to 10 s, and
+// without CAP_SYS_RESOURCE only multiples of 2 s are accepted. Thread-safe.
+class PsiTriggerMonitor {
+public:
+    PsiTriggerMonitor() = default;
+    ~PsiTriggerMonitor();
+    PsiTriggerMonitor(const PsiTriggerMonitor&) = delete;
+    PsiTriggerMonitor& operator=(const PsiTriggerMonitor&) = delete;
+
+    // spec is "RESOURCE some|full STALL in WINDOW [CGROUP]", e.g. "memory some 150ms in 1s"
+    // or "io full 50ms in 2s /system.slice". Times take us, ms or s; CGROUP is relative
+    // to the cgroup2 mount. Returns false with the reason in error.
+    bool add(const std::string& spec, std::string& error);
+    void snapshot(std::vector<PsiTriggerInfo>& out) const;
+
+    static const size_t RecentEvents = 32;
+
+private:
+    struct Trigger { int fd; PsiTriggerInfo info; };
+    void run();
+
+    mutable std::mutex mutex;
+    std::vector<Trigger> triggers;
+    std::thread worker;   // started with the first trigger
+    int wakeFd = -1;      // eventfd: the trigger set changed, or shutting down
+    bool stopping = false;
+};
+
+// ==================== SYSTEM INFO ====================
+SystemInfo getSystemInfo();
+std::string getUptime();
+int getFileDescriptorCount();
+void getSelfUsage(double& cpuSeconds, long long& rssKB);
+
+// ==================== TIMER WHEEL ====================
+// Hierarchical timing wheel for a small fixed set of timers (ids 0..Capacity-1).
+// Level 0 has Slots slots of Resolution seconds and each further level is Slots
+// times coarser; a timer sits in the finest level that reaches its deadline and
+// cascades down as time passes. Arming, cancelling and expiring are O(1) and
+// never allocate. Deadlines are rounded up to the resolution, so a timer never
+// fires early; ones beyond the top level's reach (~45 min) are clamped to it.
+class TimerWheel {
+public:
+    static const int Capacity = 32;
+    static const int Levels = 3;
+    static const int SlotBits = 6;
+    static const int Slots = 1 << SlotBits;
+    static constexpr double Resolution = 0.01;
+
+    explicit TimerWheel(double start);
+
+    void arm(int id, double deadline);
+    void cancel(int id);
+    bool armed(int id) const { return level[id] >= 0; }
+    // Moves the wheel to now and returns the timers that expired (bit per id);
+    // they are disarmed.
+    unsigned advance(double now);
+    // Earliest deadline among armed timers, or infinity.
+    double nextExpiry() const;
+
+private:
+    long long tickOf(double t) const;
+    void insert(int id);
+    void unlink(int id);
+
+    double start;
+    long long now = 0;    // ticks since start
+    unsigned pending = 0; // expired but not yet returned by advance()
+    long long deadline[Capacity];
+    int level[Capacity]; // -1 = not armed
+    int next[Capacity], prev[Capacity];
+    int slots[Levels][Slots]; // list heads, -1 = empty
+};
+
+// ==================== SAMPLER ====================
+// Each collector runs on its own interval; a sampler pass runs whatever is due
+// and publishes one snapshot with the rest carried over from the previous one.
+enum CollectorId {
+    COLLECTOR_CPU,       // /proc/stat, schedstat, sensors, load, ctxt/intr
+    COLLECTOR_PRESSURE,  // /proc/pressure
+    COLLECTOR_MEMORY,
+    COLLECTOR_NETWORK,
+    COLLECTOR_DISK,      // /proc/diskstats
+    COLLECTOR_PROCESSES, // /proc walk, per-process io/smaps/schedstat, top lists
+    COLLECTOR_CGROUPS,
+    COLLECTOR_GPU,
+    COLLECTOR_SYSTEM,    // uptime, open files, the monitor's own footprint
+    COLLECTOR_SOCKETS,
+    COLLECTOR_MOUNTS,    // filesystem usage
+    COLLECTOR_BATTERY,
+    COLLECTOR_COUNT
+};
+
+// Bounds how often a collector may run and whether the first sample waits for it.
+enum CollectorCost {
+    COST_CHEAP,     // a few fixed files
+    COST_MODERATE,  // grows with the machine (processes, cgroups)
+    COST_SLOW,      // may block or spawn; left out of the first sample
+};
+
+struct CollectorSpec {
+    const char* name;
+    CollectorCost cost;
+    double defaultInterval; // seconds, 0 = the sampler's interval
+    unsigned dependencies;  // bit per CollectorId; run first in the same pass
+};
+
+const CollectorSpec& collectorSpec(CollectorId id);
+const char* collectorCostName(CollectorCost cost);
+double minCollectorInterval(CollectorCost cost);
+bool findCollector(const std::string& name, CollectorId& id);
+// "NAME=SECONDS", e.g. "network=0.1" (the --collector-interval flag).
+bool parseCollectorInterval(const std::string& spec, CollectorId& id, double& seconds, std::string& error);
+
+// Variable-size readings live in sections shared between snapshots: a pass
+// replaces the sections of the collectors that ran and keeps the others, so
+// copying a snapshot costs the same however much state the host has. Never null.
+template <typename T>
+using Section = std::shared_ptr<const std::vector<T>>;
+
+template <typename T>
+const Section<T>& emptySection() {
+    static const Section<T> empty = std::make_shared<const std::vector<T>>();
+    return empty;
+}
+
+// One complete set of readings. The sampler thread builds a fresh snapshot every
+// pass and never touches it again after publishing, so the UI can read it
+// without locking.
+struct MetricsSnapshot {
+    unsigned long long sequence;
+    double timestamp;
+    unsigned collected; // bit per CollectorId that ran for this snapshot
+
+    bool ran(CollectorId id) const { return collected & (1u << id); }
+
+    float cpuUsage, cpuTemp, cpuFreq, peakCpu, ioWaitPct;
+    Section<float> perCoreUsage = emptySection<float>();
+    Section<SchedDelay> coreSched = emptySection<SchedDelay>(); // parallel to perCoreUsage; empty without /proc/schedstat
+    float loadAvg1, loadAvg5, loadAvg15;
+    float ctxtPerSec, intrPerSec;
+
+    MemoryDetail memDetail;
+    float ramUsagePercent, peakRam;
+
+    double downSpeed, upSpeed;
+    long long sessionRx, sessionTx;
+    Section<NetInterfaceInfo> interfaces = emptySection<NetInterfaceInfo>(); // physical first, then by name
+    int netConnections;
+    SocketStats sockets;
+
+    double diskReadSpeed, diskWriteSpeed;
+    long long sessionDiskRead, sessionDiskWrite;
+    Section<DiskDeviceInfo> diskDevices = emptySection<DiskDeviceInfo>(); // whole disks except loop/ram, physical first
+
+    Section<GPUInfo> gpus = emptySection<GPUInfo>();
+    BatteryInfo battery;
+    Section<DiskInfo> diskPartitions = emptySection<DiskInfo>();
+    Section<ProcessInfo> topProcesses = emptySection<ProcessInfo>();
+    Section<ProcessInfo> topIoProcesses = emptySection<ProcessInfo>(); // by bytes moved per second
+    Section<ProcessInfo> topMemProcesses = emptySection<ProcessInfo>(); // by PSS
+    int procIoReads;                         // /proc/[pid]/io files read this tick
+    int procSmapsReads, procSmapsPending;    // smaps_rollup files read this tick / never read yet
+    int procSchedReads;                      // /proc/[pid](/task/*)/schedstat files read this tick
+    Section<CgroupInfo> cgroups = emptySection<CgroupInfo>(); // depth-first; empty without cgroup v2
+    bool cgroupsWatched;             // tree kept current by inotify rather than re-walks
+    SystemPressure pressure;
+    Section<PsiTriggerInfo> psiTriggers = emptySection<PsiTriggerInfo>();
+    int processCount, threadCount, fdCount;
+    bool procEvents; // pid set tracked by ProcEventTracker rather than a scan
+    std::string uptime;
+
+    // The monitor process itself (all threads).
+    float selfCpuPercent;
+    long long selfRssKB;
+};
+
+// Owns every collector and their previous-tick state. All /proc and /sys access
+// (including the procSource registry, which is not thread-safe) happens on the
+// sampler thread; other threads only call latest().
+class Sampler {
+public:
+    explicit Sampler(double interval = 1.0);
+    ~Sampler() { stop(); }
+
+    // Called on the sampler thread after every publish (e.g. to wake the UI loop).
+    void setOnPublish(std::function<void()> callback) { onPublish = std::move(callback); }
+    // Track the pid set with proc connector events (falls back to scanning).
+    void setUseProcEvents(bool enable) { useProcEvents = enable; }
+    // Count sockets from /proc/net/sockstat only, without the per-state breakdown.
+    void setSocketSummary(bool enable) { socketSummary = enable; }
+    // Arms a PSI trigger (see PsiTriggerMonitor::add); callable from any thread.
+    bool addPsiTrigger(const std::string& spec, std::string& error) { return psiTriggers.add(spec, error); }
+    // Seconds between runs of one collector, clamped to its cost class's minimum.
+    // Callable from any thread; a running sampler re-arms the collector at once.
+    void setCollectorInterval(CollectorId id, double seconds);
+    double collectorInterval(CollectorId id) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return intervals[id];
+    }
+
+    void start() {
+        current = std::make_shared<MetricsSnapshot>();
+        running = true;
+        worker = std::thread(&Sampler::run, this);
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+        }
+        wake.notify_all();
+        if (worker.joinable()) worker.join();
+    }
+
+    // Latest published snapshot; never null once start() has returned.
+    std::shared_ptr<const MetricsSnapshot> latest() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return current;
+    }
+
+private:
+    void publish(std::shared_ptr<const MetricsSnapshot> snap);
+    void run();
+
+    static constexpr double FirstSampleDelay = 0.05;
+
+    double interval;
+    double intervals[COLLECTOR_COUNT]; // guarded by mutex
+    unsigned intervalsChanged = 0;     // bit per CollectorId, guarded by mutex
+    bool useProcEvents = false;
+    bool socketSummary = false;
+    bool running = false;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::thread worker;
+    std::shared_ptr<const MetricsSnapshot> current;
+    std::function<void()> onPublish;
+    PsiTriggerMonitor psiTriggers;
+};
+
+// ==================== SERIALIZATION ====================
+// Append one snapshot to out: a single NDJSON line, or a u32 length-prefixed
+// binary record (layout documented in collectors.cpp).
+void appendSnapshotJson(std::string& out, const MetricsSnapshot& m);
+void appendSnapshotBinary(std::string& out, const MetricsSnapshot& m);
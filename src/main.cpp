@@ -9,58 +9,25 @@
 #include "imgui/imgui_internal.h"
 #include "imgui/imgui_impl_glfw.h"
 #include "imgui/imgui_impl_opengl3.h"
+#include "collectors.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <signal.h>
 #include <vector>
 #include <string>
-#include <fstream>
+#include <memory>
 #include <sstream>
-#include <iostream>
 #include <iomanip>
+#include <map>
 #include <algorithm>
-#include <numeric>
-#include <dirent.h>
-#include <sys/statvfs.h>
-#include <sys/sysinfo.h>
-#include <sys/utsname.h>
-#include <unistd.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <cerrno>
+#include <cstring>
 #include <cmath>
-#include <pwd.h>
 #include <GLFW/glfw3.h>
 
-// ==================== DATA STRUCTURES ====================
-struct CPUStats { long long user, nice, system, idle, iowait, irq, softirq, steal; };
-struct NetStats { long long rxBytes, txBytes; };
-struct DiskStats { long long readBytes, writeBytes; };
-struct DiskInfo { std::string name; std::string fsType; float totalGB, usedGB, usagePercent; };
-struct GPUInfo { std::string name; int temp; int usagePercent; int memUsedMB, memTotalMB; int fanSpeed; int powerDraw; bool available; };
-struct BatteryInfo { int percent; bool charging; bool available; float powerWatts; int estimatedMinutes; };
-struct DiskIOInfo { double readBytesPerSec, writeBytesPerSec; long long totalRead, totalWrite; };
-
-struct ProcessInfo {
-    std::string name;
-    int pid;
-    float cpuPercent;
-    float memMB;
-    int threadCount;
-    char state;
-};
-
-struct SystemInfo {
-    std::string distroName, distroVersion, kernelVersion;
-    std::string hostname, username, architecture;
-    int logicalCores, physicalCores;
-    float totalRamGB;
-};
-
-struct MemoryDetail {
-    long long totalKB, availableKB, freeKB;
-    long long buffersKB, cachedKB, sreclaimableKB;
-    long long dirtyKB, writebackKB;
-    long long swapTotalKB, swapFreeKB, swapCachedKB;
-    long long sharedKB, activeKB, inactiveKB;
-};
-
 // ==================== COLOR PALETTE ====================
 namespace Colors {
     const ImVec4 Background   = ImVec4(0.05f, 0.05f, 0.08f, 1.0f);
@@ -170,7 +137,6 @@ void SetupModernStyle() {
 }
 
 // ==================== CUSTOM DRAWING ====================
-
 ImVec4 GetUsageColor(float percent) {
     if (percent > 90.0f) return Colors::Red;
     if (percent > 75.0f) return Colors::Orange;
@@ -260,626 +226,243 @@ void CardHeader(const char* icon, const char* title, ImVec4 color) {
     ImGui::Spacing();
 }
 
-void MiniGraph(const char* id, float* data, int count, ImVec4 color, float height = 40.0f) {
+// scaleMax = FLT_MAX scales to the visible samples.
+void MiniGraph(const char* id, const float* data, int count, ImVec4 color, float height = 40.0f, int offset = 0,
+               float scaleMax = 100.0f) {
     ImGui::PushStyleColor(ImGuiCol_PlotLines, color);
     ImGui::PushStyleColor(ImGuiCol_FrameBg, ImVec4(0.08f, 0.08f, 0.10f, 0.8f));
-    ImGui::PlotLines(id, data, count, 0, NULL, 0, 100, ImVec2(-1, height));
+    ImGui::PlotLines(id, data, count, offset, NULL, 0, scaleMax, ImVec2(-1, height));
     ImGui::PopStyleColor(2);
 }
 
+void MiniGraph(const char* id, const MetricHistory& history, ImVec4 color, float height = 40.0f, float scaleMax = 100.0f) {
+    MiniGraph(id, history.data(), history.size(), color, height, history.offset(), scaleMax);
+}
+
 void DrawStatRow(const char* label, const char* value, ImVec4 valueColor = Colors::TextPrimary) {
     ImGui::TextColored(Colors::TextSecondary, "%s", label);
     ImGui::SameLine(180);
     ImGui::TextColored(valueColor, "%s", value);
 }
 
-// ==================== CPU FUNCTIONS ====================
-CPUStats readCPUStats() {
-    std::ifstream file("/proc/stat");
-    std::string line;
-    CPUStats stats = {0};
-    if (file.is_open()) {
-        getline(file, line);
-        std::stringstream ss(line);
-        std::string label;
-        ss >> label >> stats.user >> stats.nice >> stats.system >> stats.idle
-           >> stats.iowait >> stats.irq >> stats.softirq >> stats.steal;
-    }
-    return stats;
-}
-
-std::vector<CPUStats> readPerCoreCPUStats() {
-    std::vector<CPUStats> cores;
-    std::ifstream file("/proc/stat");
-    std::string line;
-    getline(file, line); // skip total
-    while (getline(file, line)) {
-        if (line.substr(0, 3) != "cpu") break;
-        CPUStats s = {0};
-        std::stringstream ss(line);
-        std::string label;
-        ss >> label >> s.user >> s.nice >> s.system >> s.idle
-           >> s.iowait >> s.irq >> s.softirq >> s.steal;
-        cores.push_back(s);
-    }
-    return cores;
-}
-
-float calcCPUUsage(const CPUStats& oldS, const CPUStats& newS) {
-    long long prevIdle = oldS.idle + oldS.iowait;
-    long long idle = newS.idle + newS.iowait;
-    long long prevTotal = prevIdle + oldS.user + oldS.nice + oldS.system + oldS.irq + oldS.softirq + oldS.steal;
-    long long total = idle + newS.user + newS.nice + newS.system + newS.irq + newS.softirq + newS.steal;
-    long long totald = total - prevTotal;
-    long long idled = idle - prevIdle;
-    if (totald <= 0) return 0.0f;
-    return (float)(totald - idled) / (float)totald;
-}
-
-float getCPUTemp() {
-    const char* paths[] = {
-        "/sys/class/thermal/thermal_zone0/temp",
-        "/sys/class/hwmon/hwmon0/temp1_input",
-        "/sys/class/hwmon/hwmon1/temp1_input",
-        "/sys/class/hwmon/hwmon2/temp1_input",
-        "/sys/class/hwmon/hwmon3/temp1_input"
-    };
-    for (const char* path : paths) {
-        std::ifstream file(path);
-        if (file.is_open()) {
-            long long temp;
-            file >> temp;
-            if (temp > 1000) return temp / 1000.0f;
-            return (float)temp;
-        }
-    }
-    return 0.0f;
-}
-
-float getCPUFrequency() {
-    std::ifstream file("/sys/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq");
-    if (file.is_open()) {
-        long long freq;
-        file >> freq;
-        return freq / 1000.0f; // MHz
-    }
-    std::ifstream cpuinfo("/proc/cpuinfo");
-    std::string line;
-    while (getline(cpuinfo, line)) {
-        if (line.find("cpu MHz") != std::string::npos) {
-            size_t pos = line.find(':');
-            if (pos != std::string::npos) return std::stof(line.substr(pos + 1));
-        }
-    }
-    return 0.0f;
-}
-
-float getCPUMaxFrequency() {
-    std::ifstream file("/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_max_freq");
-    if (file.is_open()) {
-        long long freq;
-        file >> freq;
-        return freq / 1000.0f;
-    }
-    return 0.0f;
-}
-
-int getCPUCoreCount() {
-    std::ifstream file("/proc/cpuinfo");
-    std::string line;
-    int count = 0;
-    while (getline(file, line)) {
-        if (line.find("processor") == 0) count++;
-    }
-    return count > 0 ? count : 1;
-}
-
-int getPhysicalCoreCount() {
-    std::ifstream file("/proc/cpuinfo");
-    std::string line;
-    std::vector<std::string> coreIds;
-    while (getline(file, line)) {
-        if (line.find("core id") != std::string::npos) {
-            size_t pos = line.find(':');
-            if (pos != std::string::npos) {
-                std::string id = line.substr(pos + 1);
-                // trim
-                id.erase(0, id.find_first_not_of(" \t"));
-                id.erase(id.find_last_not_of(" \t") + 1);
-                if (std::find(coreIds.begin(), coreIds.end(), id) == coreIds.end())
-                    coreIds.push_back(id);
-            }
-        }
-    }
-    return coreIds.empty() ? 1 : (int)coreIds.size();
-}
-
-std::string getCPUModel() {
-    std::ifstream file("/proc/cpuinfo");
-    std::string line;
-    while (getline(file, line)) {
-        if (line.find("model name") != std::string::npos) {
-            size_t pos = line.find(':');
-            if (pos != std::string::npos) {
-                std::string model = line.substr(pos + 2);
-                if (model.length() > 40) model = model.substr(0, 37) + "...";
-                return model;
-            }
-        }
-    }
-    return "Unknown CPU";
-}
-
-void getLoadAverages(float& l1, float& l5, float& l15) {
-    std::ifstream file("/proc/loadavg");
-    file >> l1 >> l5 >> l15;
-}
-
-void getContextSwitchesAndInterrupts(long long& ctxt, long long& intr) {
-    std::ifstream file("/proc/stat");
-    std::string line;
-    ctxt = 0; intr = 0;
-    while (getline(file, line)) {
-        if (line.substr(0, 4) == "ctxt") {
-            std::stringstream ss(line);
-            std::string label;
-            ss >> label >> ctxt;
-        } else if (line.substr(0, 4) == "intr") {
-            std::stringstream ss(line);
-            std::string label;
-            ss >> label >> intr;
-        }
-    }
-}
-
-// ==================== MEMORY FUNCTIONS ====================
-MemoryDetail getMemoryDetail() {
-    MemoryDetail m = {0};
-    std::ifstream file("/proc/meminfo");
-    std::string line;
-    while (getline(file, line)) {
-        std::stringstream ss(line);
-        std::string label;
-        long long value;
-        ss >> label >> value;
-        if (label == "MemTotal:")       m.totalKB = value;
-        else if (label == "MemAvailable:") m.availableKB = value;
-        else if (label == "MemFree:")    m.freeKB = value;
-        else if (label == "Buffers:")    m.buffersKB = value;
-        else if (label == "Cached:")     m.cachedKB = value;
-        else if (label == "SReclaimable:") m.sreclaimableKB = value;
-        else if (label == "Dirty:")      m.dirtyKB = value;
-        else if (label == "Writeback:")  m.writebackKB = value;
-        else if (label == "SwapTotal:")  m.swapTotalKB = value;
-        else if (label == "SwapFree:")   m.swapFreeKB = value;
-        else if (label == "SwapCached:") m.swapCachedKB = value;
-        else if (label == "Shmem:")      m.sharedKB = value;
-        else if (label == "Active:")     m.activeKB = value;
-        else if (label == "Inactive:")   m.inactiveKB = value;
-    }
-    return m;
-}
-
-// ==================== NETWORK FUNCTIONS ====================
-NetStats readNetStats() {
-    std::ifstream file("/proc/net/dev");
-    std::string line;
-    NetStats total = {0, 0};
-    getline(file, line); getline(file, line); // skip headers
-    while (getline(file, line)) {
-        if (line.find("lo:") != std::string::npos) continue;
-        size_t colon = line.find(':');
-        if (colon != std::string::npos) line[colon] = ' ';
-        std::stringstream ss(line);
-        std::string iface;
-        long long rx = 0, tx = 0, junk = 0;
-        ss >> iface >> rx >> junk >> junk >> junk >> junk >> junk >> junk >> junk >> tx;
-        if (!ss.fail()) { total.rxBytes += rx; total.txBytes += tx; }
-    }
-    return total;
-}
-
-int getNetworkConnectionCount() {
-    int count = 0;
-    std::ifstream tcp("/proc/net/tcp");
-    std::string line;
-    if (tcp.is_open()) {
-        getline(tcp, line); // header
-        while (getline(tcp, line)) count++;
-    }
-    std::ifstream tcp6("/proc/net/tcp6");
-    if (tcp6.is_open()) {
-        getline(tcp6, line);
-        while (getline(tcp6, line)) count++;
-    }
-    return count;
+std::string formatSpeed(double bytes) {
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1);
+    if (bytes > 1024 * 1024) ss << (bytes / (1024.0 * 1024.0)) << " MB/s";
+    else if (bytes > 1024) ss << (bytes / 1024.0) << " KB/s";
+    else ss << bytes << " B/s";
+    return ss.str();
 }
 
-// ==================== DISK FUNCTIONS ====================
-DiskStats readDiskStats() {
-    std::ifstream file("/proc/diskstats");
-    std::string line;
-    DiskStats total = {0, 0};
-    while (getline(file, line)) {
-        std::stringstream ss(line);
-        int major, minor;
-        std::string name;
-        long long reads, readsMerged, sectorsRead, readTime;
-        long long writes, writesMerged, sectorsWritten, writeTime;
-        ss >> major >> minor >> name >> reads >> readsMerged >> sectorsRead >> readTime
-           >> writes >> writesMerged >> sectorsWritten >> writeTime;
-        if (name.find("loop") != std::string::npos) continue;
-        if (name.length() == 3 || (name.find("nvme") != std::string::npos && name.find("p") == std::string::npos)) {
-            total.readBytes += sectorsRead * 512;
-            total.writeBytes += sectorsWritten * 512;
-        }
-    }
-    return total;
+std::string formatBytes(long long bytes) {
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1);
+    if (bytes > 1073741824LL) ss << (bytes / 1073741824.0) << " GB";
+    else if (bytes > 1048576LL) ss << (bytes / 1048576.0) << " MB";
+    else if (bytes > 1024LL) ss << (bytes / 1024.0) << " KB";
+    else ss << bytes << " B";
+    return ss.str();
 }
 
-std::vector<DiskInfo> getDiskPartitions() {
-    std::vector<DiskInfo> disks;
-    std::ifstream mounts("/proc/mounts");
-    std::string line;
-    while (getline(mounts, line)) {
-        std::stringstream ss(line);
-        std::string device, mountPoint, fsType;
-        ss >> device >> mountPoint >> fsType;
-        if (fsType == "ext4" || fsType == "btrfs" || fsType == "xfs" || fsType == "zfs" ||
-            fsType == "ntfs" || fsType == "vfat" || fsType == "exfat" || fsType == "f2fs" || fsType == "tmpfs") {
-            if (fsType == "tmpfs" && mountPoint != "/tmp") continue; // only show /tmp for tmpfs
-            struct statvfs stat;
-            if (statvfs(mountPoint.c_str(), &stat) == 0) {
-                DiskInfo info;
-                info.name = mountPoint;
-                info.fsType = fsType;
-                if (info.name.length() > 18) info.name = "..." + info.name.substr(info.name.length() - 15);
-                info.totalGB = (stat.f_blocks * stat.f_frsize) / (1024.0 * 1024.0 * 1024.0);
-                float freeGB = (stat.f_bfree * stat.f_frsize) / (1024.0 * 1024.0 * 1024.0);
-                info.usedGB = info.totalGB - freeGB;
-                info.usagePercent = (info.totalGB > 0) ? (info.usedGB / info.totalGB) : 0;
-                if (info.totalGB > 0.1) disks.push_back(info);
-            }
-        }
-    }
-    return disks;
+std::string formatDuration(long long ns) {
+    char buf[32];
+    if (ns >= 1000000000LL) snprintf(buf, sizeof(buf), "%.2f s", ns / 1e9);
+    else if (ns >= 1000000LL) snprintf(buf, sizeof(buf), "%.2f ms", ns / 1e6);
+    else if (ns >= 1000LL) snprintf(buf, sizeof(buf), "%.1f us", ns / 1e3);
+    else snprintf(buf, sizeof(buf), "%lld ns", ns);
+    return buf;
 }
 
-// ==================== GPU FUNCTIONS ====================
-GPUInfo getGPUInfo() {
-    GPUInfo gpu = {"", 0, 0, 0, 0, 0, 0, false};
-
-    // NVIDIA via nvidia-smi
-    FILE* pipe = popen("nvidia-smi --query-gpu=name,temperature.gpu,utilization.gpu,memory.used,memory.total,fan.speed,power.draw --format=csv,noheader,nounits 2>/dev/null", "r");
-    if (pipe) {
-        char buffer[512];
-        if (fgets(buffer, sizeof(buffer), pipe)) {
-            std::stringstream ss(buffer);
-            std::string name, temp, usage, memUsed, memTotal, fan, power;
-            getline(ss, name, ',');
-            getline(ss, temp, ',');
-            getline(ss, usage, ',');
-            getline(ss, memUsed, ',');
-            getline(ss, memTotal, ',');
-            getline(ss, fan, ',');
-            getline(ss, power, ',');
-            gpu.name = name;
-            if (gpu.name.length() > 28) gpu.name = gpu.name.substr(0, 25) + "...";
-            try {
-                gpu.temp = std::stoi(temp);
-                gpu.usagePercent = std::stoi(usage);
-                gpu.memUsedMB = std::stoi(memUsed);
-                gpu.memTotalMB = std::stoi(memTotal);
-                gpu.fanSpeed = std::stoi(fan);
-                gpu.powerDraw = (int)std::stof(power);
-                gpu.available = true;
-            } catch (...) {}
-        }
-        pclose(pipe);
-    }
-
-    // AMD fallback
-    if (!gpu.available) {
-        const char* amdPaths[] = {
-            "/sys/class/drm/card0/device/hwmon/hwmon0/temp1_input",
-            "/sys/class/drm/card0/device/hwmon/hwmon1/temp1_input",
-            "/sys/class/drm/card1/device/hwmon/hwmon0/temp1_input"
-        };
-        for (const char* p : amdPaths) {
-            std::ifstream f(p);
-            if (f.is_open()) {
-                int t; f >> t;
-                gpu.temp = t / 1000;
-                gpu.name = "AMD GPU";
-                gpu.available = true;
-                // try to get usage
-                std::ifstream busy("/sys/class/drm/card0/device/gpu_busy_percent");
-                if (busy.is_open()) busy >> gpu.usagePercent;
-                break;
-            }
-        }
+// ==================== RENDER GOVERNOR ====================
+// Data changes once per sample, so the UI loop sleeps in glfwWaitEventsTimeout()
+// instead of spinning at the display refresh rate. It wakes on input, on a new
+// snapshot (the sampler posts an empty event) or on the optional low-rate
+// animation tick, and draws a few frames so ImGui can settle hover/layout state.
+struct RenderGovernor {
+    static constexpr int SettleFrames = 3;
+    double animInterval = 0; // seconds between animation frames, 0 = animations off
+    int pendingFrames = SettleFrames;
+
+    void requestRedraw() { pendingFrames = SettleFrames; }
+
+    // Blocks until there is a reason to draw. While iconified nothing is drawn,
+    // so it waits for events with no timeout at all.
+    void wait(GLFWwindow* window) {
+        if (glfwGetWindowAttrib(window, GLFW_ICONIFIED)) { glfwWaitEvents(); return; }
+        if (pendingFrames > 0) { glfwPollEvents(); return; }
+        // Without animations the timeout is only a safety net; new samples post an event.
+        double timeout = animInterval > 0 ? animInterval : 5.0;
+        double before = glfwGetTime();
+        glfwWaitEventsTimeout(timeout);
+        if (glfwGetTime() - before < timeout) requestRedraw(); // input or new sample
+        else if (animInterval > 0) pendingFrames = 1;
     }
 
-    // Intel iGPU fallback
-    if (!gpu.available) {
-        std::ifstream f("/sys/class/drm/card0/device/vendor");
-        if (f.is_open()) {
-            std::string v; f >> v;
-            if (v == "0x8086") { gpu.name = "Intel iGPU"; gpu.available = true; }
-        }
+    // True if this iteration should build and present a frame.
+    bool beginFrame() {
+        if (pendingFrames <= 0) return false;
+        pendingFrames--;
+        return true;
     }
+};
 
-    return gpu;
-}
-
-// ==================== BATTERY FUNCTIONS ====================
-BatteryInfo getBatteryInfo() {
-    BatteryInfo bat = {0, false, false, 0, 0};
-    const char* paths[] = {"/sys/class/power_supply/BAT0", "/sys/class/power_supply/BAT1"};
-    for (const char* base : paths) {
-        std::string capPath = std::string(base) + "/capacity";
-        std::ifstream capFile(capPath);
-        if (capFile.is_open()) {
-            capFile >> bat.percent;
-            bat.available = true;
-
-            std::ifstream statusFile(std::string(base) + "/status");
-            if (statusFile.is_open()) {
-                std::string status; statusFile >> status;
-                bat.charging = (status == "Charging" || status == "Full");
-            }
-
-            std::ifstream powerFile(std::string(base) + "/power_now");
-            if (powerFile.is_open()) {
-                long long power; powerFile >> power;
-                bat.powerWatts = power / 1000000.0f;
-            }
+// ==================== HEADLESS MODE ====================
+static volatile sig_atomic_t headlessStop = 0;
 
-            // estimated time
-            std::ifstream energyNow(std::string(base) + "/energy_now");
-            std::ifstream energyFull(std::string(base) + "/energy_full");
-            if (energyNow.is_open() && energyFull.is_open() && bat.powerWatts > 0.1f) {
-                long long eNow, eFull;
-                energyNow >> eNow;
-                energyFull >> eFull;
-                if (!bat.charging)
-                    bat.estimatedMinutes = (int)((eNow / 1000000.0f) / bat.powerWatts * 60);
-                else
-                    bat.estimatedMinutes = (int)(((eFull - eNow) / 1000000.0f) / bat.powerWatts * 60);
-            }
-            break;
-        }
+// --psi-trigger specs the kernel (or the parser) rejects are reported and skipped.
+static void addPsiTriggers(Sampler& sampler, const std::vector<std::string>& specs) {
+    for (const std::string& spec : specs) {
+        std::string error;
+        if (!sampler.addPsiTrigger(spec, error)) fprintf(stderr, "PSI trigger \"%s\": %s\n", spec.c_str(), error.c_str());
     }
-    return bat;
 }
 
-// ==================== PROCESS FUNCTIONS ====================
-struct ProcCPUTick { int pid; long long utime, stime; };
-
-std::vector<ProcCPUTick> readAllProcTicks() {
-    std::vector<ProcCPUTick> ticks;
-    DIR* dir = opendir("/proc");
-    if (!dir) return ticks;
-    struct dirent* entry;
-    while ((entry = readdir(dir)) != NULL) {
-        if (entry->d_type != DT_DIR) continue;
-        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
-        int pid = atoi(entry->d_name);
-        std::string statPath = std::string("/proc/") + entry->d_name + "/stat";
-        std::ifstream f(statPath);
-        if (!f.is_open()) continue;
-        std::string line; getline(f, line);
-        // find closing paren of comm
-        size_t rp = line.rfind(')');
-        if (rp == std::string::npos) continue;
-        std::stringstream ss(line.substr(rp + 2));
-        char state;
-        long long ppid, pgrp, session, tty, tpgid, flags;
-        long long minflt, cminflt, majflt, cmajflt, utime, stime;
-        ss >> state >> ppid >> pgrp >> session >> tty >> tpgid >> flags
-           >> minflt >> cminflt >> majflt >> cmajflt >> utime >> stime;
-        ticks.push_back({pid, utime, stime});
+// --collector-interval specs are applied in order; bad ones are reported and skipped.
+static void setCollectorIntervals(Sampler& sampler, const std::vector<std::string>& specs) {
+    for (const std::string& spec : specs) {
+        CollectorId id;
+        double seconds;
+        std::string error;
+        if (parseCollectorInterval(spec, id, seconds, error)) sampler.setCollectorInterval(id, seconds);
+        else fprintf(stderr, "Collector interval \"%s\": %s\n", spec.c_str(), error.c_str());
     }
-    closedir(dir);
-    return ticks;
 }
 
-std::vector<ProcessInfo> getTopProcesses(const std::vector<ProcCPUTick>& oldTicks, const std::vector<ProcCPUTick>& newTicks, long long totalCpuDelta, int maxCount = 20) {
-    std::vector<ProcessInfo> procs;
-    long long clkTck = sysconf(_SC_CLK_TCK);
-    long long pageSize = sysconf(_SC_PAGESIZE);
-
-    for (const auto& nt : newTicks) {
-        float cpuPct = 0;
-        for (const auto& ot : oldTicks) {
-            if (ot.pid == nt.pid) {
-                long long delta = (nt.utime + nt.stime) - (ot.utime + ot.stime);
-                if (totalCpuDelta > 0) cpuPct = (float)delta / (float)totalCpuDelta * 100.0f;
-                break;
-            }
+// Streams every sample to stdout or a file without touching GLFW/ImGui, so it
+// runs on servers with no display.
+int runHeadless(double interval, bool binary, const std::string& outputPath, long long maxSamples,
+                bool procEvents, bool sockstat, const std::vector<std::string>& psiTriggers,
+                const std::vector<std::string>& collectorIntervals) {
+    FILE* out = stdout;
+    if (!outputPath.empty() && outputPath != "-") {
+        out = fopen(outputPath.c_str(), binary ? "wb" : "w");
+        if (!out) {
+            fprintf(stderr, "Cannot open %s: %s\n", outputPath.c_str(), strerror(errno));
+            return 1;
         }
-
-        std::string statPath = "/proc/" + std::to_string(nt.pid) + "/stat";
-        std::ifstream f(statPath);
-        if (!f.is_open()) continue;
-        std::string line; getline(f, line);
-        // extract name
-        size_t lp = line.find('(');
-        size_t rp = line.rfind(')');
-        if (lp == std::string::npos || rp == std::string::npos) continue;
-        std::string name = line.substr(lp + 1, rp - lp - 1);
-        if (name.length() > 20) name = name.substr(0, 17) + "...";
-
-        // parse rest of fields for state, threads, rss
-        std::stringstream ss(line.substr(rp + 2));
-        char state;
-        long long ppid, pgrp, session, tty, tpgid, flags;
-        long long minflt, cminflt, majflt, cmajflt, utime2, stime2;
-        long long cutime, cstime, priority, nice, numThreads, itrealvalue, starttime;
-        long long vsize, rss;
-        ss >> state >> ppid >> pgrp >> session >> tty >> tpgid >> flags
-           >> minflt >> cminflt >> majflt >> cmajflt >> utime2 >> stime2
-           >> cutime >> cstime >> priority >> nice >> numThreads >> itrealvalue >> starttime
-           >> vsize >> rss;
-
-        float memMB = (rss * pageSize) / (1024.0f * 1024.0f);
-
-        ProcessInfo pi;
-        pi.name = name;
-        pi.pid = nt.pid;
-        pi.cpuPercent = cpuPct;
-        pi.memMB = memMB;
-        pi.threadCount = (int)numThreads;
-        pi.state = state;
-        procs.push_back(pi);
     }
-
-    // sort by CPU desc
-    std::sort(procs.begin(), procs.end(), [](const ProcessInfo& a, const ProcessInfo& b) {
-        return a.cpuPercent > b.cpuPercent;
+    signal(SIGINT, [](int) { headlessStop = 1; });
+    signal(SIGTERM, [](int) { headlessStop = 1; });
+    signal(SIGPIPE, SIG_IGN);
+
+    std::mutex mutex;
+    std::condition_variable published;
+    Sampler sampler(interval);
+    sampler.setUseProcEvents(procEvents);
+    sampler.setSocketSummary(sockstat);
+    addPsiTriggers(sampler, psiTriggers);
+    setCollectorIntervals(sampler, collectorIntervals);
+    sampler.setOnPublish([&] {
+        std::lock_guard<std::mutex> lock(mutex);
+        published.notify_all();
     });
+    sampler.start();
 
-    if ((int)procs.size() > maxCount) procs.resize(maxCount);
-    return procs;
-}
-
-// ==================== SYSTEM INFO ====================
-SystemInfo getSystemInfo() {
-    SystemInfo info;
-
-    // Distro from /etc/os-release
-    std::ifstream osrel("/etc/os-release");
-    std::string line;
-    while (getline(osrel, line)) {
-        if (line.substr(0, 12) == "PRETTY_NAME=") {
-            info.distroName = line.substr(13);
-            if (!info.distroName.empty() && info.distroName.back() == '"')
-                info.distroName.pop_back();
-        } else if (line.substr(0, 11) == "VERSION_ID=") {
-            info.distroVersion = line.substr(12);
-            if (!info.distroVersion.empty() && info.distroVersion.back() == '"')
-                info.distroVersion.pop_back();
-        }
-    }
-
-    // Kernel
-    struct utsname uts;
-    if (uname(&uts) == 0) {
-        info.kernelVersion = uts.release;
-        info.architecture = uts.machine;
-    }
-
-    // Hostname
-    char hostname[256];
-    if (gethostname(hostname, sizeof(hostname)) == 0)
-        info.hostname = hostname;
-
-    // Username
-    struct passwd* pw = getpwuid(getuid());
-    if (pw) info.username = pw->pw_name;
-    else {
-        char* user = getenv("USER");
-        info.username = user ? user : "unknown";
-    }
-
-    info.logicalCores = getCPUCoreCount();
-    info.physicalCores = getPhysicalCoreCount();
-
-    // Total RAM
-    std::ifstream meminfo("/proc/meminfo");
-    while (getline(meminfo, line)) {
-        if (line.substr(0, 9) == "MemTotal:") {
-            std::stringstream ss(line);
-            std::string label; long long val;
-            ss >> label >> val;
-            info.totalRamGB = val / (1024.0f * 1024.0f);
-            break;
+    std::string buf;
+    unsigned long long lastSequence = 0;
+    long long written = 0;
+    while (!headlessStop && (maxSamples <= 0 || written < maxSamples)) {
+        std::shared_ptr<const MetricsSnapshot> snap;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            // Short timeout so a signal is noticed promptly.
+            published.wait_for(lock, std::chrono::milliseconds(200), [&] {
+                snap = sampler.latest();
+                return snap && snap->sequence != lastSequence;
+            });
         }
+        if (!snap || snap->sequence == lastSequence) continue;
+        lastSequence = snap->sequence;
+
+        buf.clear();
+        if (binary) appendSnapshotBinary(buf, *snap);
+        else appendSnapshotJson(buf, *snap);
+        if (fwrite(buf.data(), 1, buf.size(), out) != buf.size() || fflush(out) != 0) break; // reader went away
+        written++;
     }
 
-    return info;
-}
-
-std::string getUptime() {
-    std::ifstream file("/proc/uptime");
-    double uptime;
-    file >> uptime;
-    int days = (int)(uptime / 86400);
-    int hours = (int)((uptime - days * 86400) / 3600);
-    int mins = (int)((uptime - days * 86400 - hours * 3600) / 60);
-    std::stringstream ss;
-    if (days > 0) ss << days << "d ";
-    ss << hours << "h " << mins << "m";
-    return ss.str();
+    sampler.stop();
+    if (out != stdout) fclose(out);
+    return 0;
 }
 
-int getProcessCount() {
-    int count = 0;
-    DIR* dir = opendir("/proc");
-    if (dir) {
-        struct dirent* entry;
-        while ((entry = readdir(dir)) != NULL) {
-            if (entry->d_type == DT_DIR && entry->d_name[0] >= '0' && entry->d_name[0] <= '9')
-                count++;
-        }
-        closedir(dir);
-    }
-    return count;
-}
+// ==================== MAIN ====================
+struct Options {
+    int historySize = 120; // samples per graph, one per run of its collector (1 s by default)
+    bool animate = false;  // low-rate (10 fps) header animation while idle
+
+    bool headless = false;
+    double interval = 1.0;     // seconds between samples
+    bool binary = false;       // headless: length-prefixed binary instead of NDJSON
+    std::string output;        // headless: file path, empty or "-" for stdout
+    long long count = 0;       // headless: stop after this many samples, 0 = forever
+
+    std::string procRoot, sysRoot; // alternative procfs/sysfs mounts, empty = /proc, /sys
+    std::string nvidiaSmi;         // nvidia-smi executable, empty = from PATH
+    bool procEvents = false;       // track pids with proc connector events, scan if unavailable
+    bool sockstat = false;         // socket counts from /proc/net/sockstat only
+    std::vector<std::string> psiTriggers; // e.g. "memory some 150ms in 1s", see PsiTriggerMonitor
+    std::vector<std::string> collectorIntervals; // e.g. "network=0.1", see CollectorId
+};
 
-int getTotalThreadCount() {
-    int total = 0;
-    DIR* dir = opendir("/proc");
-    if (!dir) return 0;
-    struct dirent* entry;
-    while ((entry = readdir(dir)) != NULL) {
-        if (entry->d_type != DT_DIR) continue;
-        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
-        std::string statusPath = std::string("/proc/") + entry->d_name + "/status";
-        std::ifstream f(statusPath);
-        std::string line;
-        while (getline(f, line)) {
-            if (line.substr(0, 8) == "Threads:") {
-                std::stringstream ss(line);
-                std::string label; int t;
-                ss >> label >> t;
-                total += t;
-                break;
-            }
+Options parseOptions(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--history" && i + 1 < argc) {
+            // 120 samples (2 min) up to 24 h at the 1 s tick
+            opt.historySize = std::max(120, std::min(atoi(argv[++i]), 86400));
+        } else if (arg == "--animate") {
+            opt.animate = true;
+        } else if (arg == "--headless") {
+            opt.headless = true;
+        } else if (arg == "--interval" && i + 1 < argc) {
+            opt.interval = std::max(0.05, atof(argv[++i]));
+        } else if (arg == "--format" && i + 1 < argc) {
+            std::string fmt = argv[++i];
+            if (fmt == "binary") opt.binary = true;
+            else if (fmt != "ndjson") fprintf(stderr, "Unknown format: %s (expected ndjson or binary)\n", fmt.c_str());
+        } else if (arg == "--output" && i + 1 < argc) {
+            opt.output = argv[++i];
+        } else if (arg == "--count" && i + 1 < argc) {
+            opt.count = atoll(argv[++i]);
+        } else if (arg == "--proc-root" && i + 1 < argc) {
+            opt.procRoot = argv[++i];
+        } else if (arg == "--sys-root" && i + 1 < argc) {
+            opt.sysRoot = argv[++i];
+        } else if (arg == "--nvidia-smi" && i + 1 < argc) {
+            opt.nvidiaSmi = argv[++i];
+        } else if (arg == "--proc-events") {
+            opt.procEvents = true;
+        } else if (arg == "--sockstat") {
+            opt.sockstat = true;
+        } else if (arg == "--psi-trigger" && i + 1 < argc) {
+            opt.psiTriggers.push_back(argv[++i]);
+        } else if (arg == "--collector-interval" && i + 1 < argc) {
+            opt.collectorIntervals.push_back(argv[++i]);
+        } else if (arg == "--help" || arg == "-h") {
+            printf("Usage: monitor [--history SAMPLES] [--animate] [--interval SECONDS]\n"
+                   "       monitor --headless [--interval SECONDS] [--format ndjson|binary]\n"
+                   "               [--output PATH] [--count N]\n"
+                   "       common: [--proc-root DIR] [--sys-root DIR] [--nvidia-smi PATH] [--proc-events]\n"
+                   "               [--sockstat] [--psi-trigger \"RESOURCE some|full STALL in WINDOW [CGROUP]\"]...\n"
+                   "               [--collector-interval NAME=SECONDS]...\n");
+            exit(0);
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", arg.c_str());
         }
     }
-    closedir(dir);
-    return total;
-}
-
-int getFileDescriptorCount() {
-    std::ifstream file("/proc/sys/fs/file-nr");
-    int allocated = 0;
-    if (file.is_open()) file >> allocated;
-    return allocated;
+    return opt;
 }
 
-std::string formatSpeed(double bytes) {
-    std::stringstream ss;
-    ss << std::fixed << std::setprecision(1);
-    if (bytes > 1024 * 1024) ss << (bytes / (1024.0 * 1024.0)) << " MB/s";
-    else if (bytes > 1024) ss << (bytes / 1024.0) << " KB/s";
-    else ss << bytes << " B/s";
-    return ss.str();
-}
+int main(int argc, char** argv) {
+    Options opt = parseOptions(argc, argv);
+    setHostRoots(opt.procRoot, opt.sysRoot);
+    setNvidiaSmiCommand(opt.nvidiaSmi);
+    if (opt.headless)
+        return runHeadless(opt.interval, opt.binary, opt.output, opt.count, opt.procEvents, opt.sockstat, opt.psiTriggers,
+                           opt.collectorIntervals);
 
-std::string formatBytes(long long bytes) {
-    std::stringstream ss;
-    ss << std::fixed << std::setprecision(1);
-    if (bytes > 1073741824LL) ss << (bytes / 1073741824.0) << " GB";
-    else if (bytes > 1048576LL) ss << (bytes / 1048576.0) << " MB";
-    else if (bytes > 1024LL) ss << (bytes / 1024.0) << " KB";
-    else ss << bytes << " B";
-    return ss.str();
-}
-
-// ==================== MAIN ====================
-int main(int, char**) {
     glfwSetErrorCallback([](int error, const char* description){
         fprintf(stderr, "GLFW Error %d: %s\n", error, description);
     });
@@ -906,11 +489,16 @@ int main(int, char**) {
     ImGui_ImplOpenGL3_Init(glsl_version);
 
     // ===== INITIAL STATE =====
-    CPUStats oldCpu = readCPUStats();
-    std::vector<CPUStats> oldCoreCpu = readPerCoreCPUStats();
-    NetStats oldNet = readNetStats();
-    DiskStats oldDisk = readDiskStats();
-    std::vector<ProcCPUTick> oldProcTicks = readAllProcTicks();
+    Sampler sampler(opt.interval);
+    sampler.setUseProcEvents(opt.procEvents);
+    sampler.setSocketSummary(opt.sockstat);
+    addPsiTriggers(sampler, opt.psiTriggers);
+    setCollectorIntervals(sampler, opt.collectorIntervals);
+    sampler.setOnPublish([] { glfwPostEmptyEvent(); });
+    sampler.start();
+
+    RenderGovernor governor;
+    if (opt.animate) governor.animInterval = 0.1;
 
     std::string cpuModel = getCPUModel();
     int cpuCores = getCPUCoreCount();
@@ -918,138 +506,128 @@ int main(int, char**) {
     float cpuMaxFreq = getCPUMaxFrequency();
     SystemInfo sysInfo = getSystemInfo();
 
-    float cpuUsage = 0, cpuTemp = 0, cpuFreq = 0;
-    float peakCpu = 0;
-    std::vector<float> perCoreUsage;
-    float loadAvg1 = 0, loadAvg5 = 0, loadAvg15 = 0;
-    long long contextSwitches = 0, interrupts = 0;
-    long long prevCtxt = 0, prevIntr = 0;
-    float ctxtPerSec = 0, intrPerSec = 0;
-
-    MemoryDetail memDetail = {};
-    float ramUsagePercent = 0;
-    float peakRam = 0;
-
-    double downSpeed = 0, upSpeed = 0;
-    long long sessionRx = 0, sessionTx = 0;
-    long long startRx = oldNet.rxBytes, startTx = oldNet.txBytes;
-    int netConnections = 0;
-
-    double diskReadSpeed = 0, diskWriteSpeed = 0;
-    long long startDiskRead = oldDisk.readBytes, startDiskWrite = oldDisk.writeBytes;
-
-    GPUInfo gpu = {};
-    BatteryInfo battery = {};
-    std::vector<DiskInfo> diskPartitions;
-    std::vector<ProcessInfo> topProcesses;
-    int processCount = 0;
-    int threadCount = 0;
-    int fdCount = 0;
-
-    const int HISTORY_SIZE = 120;
-    std::vector<float> cpuHistory(HISTORY_SIZE, 0), ramHistory(HISTORY_SIZE, 0);
-    std::vector<float> gpuHistory(HISTORY_SIZE, 0);
-    std::vector<float> netDownHistory(HISTORY_SIZE, 0), netUpHistory(HISTORY_SIZE, 0);
-    std::vector<float> ioWaitHistory(HISTORY_SIZE, 0);
-
-    double lastUpdateTime = 0;
-    int slowUpdateCounter = 0;
+    const int historySize = opt.historySize;
+    MetricHistory cpuHistory(historySize), ramHistory(historySize);
+    std::vector<MetricHistory> gpuHistory; // per GPU, in snapshot order
+    MetricHistory netDownHistory(historySize), netUpHistory(historySize);
+    MetricHistory ioWaitHistory(historySize);
+    // PSI "some" share of each interval, per resource
+    MetricHistory cpuPressureHistory(historySize), memPressureHistory(historySize), ioPressureHistory(historySize);
+    MetricHistory selfCpuHistory(historySize);
+    std::vector<MetricHistory> coreHistory;
+    std::vector<LatencyHistogram> perfStats;
+
+    // CPU% series for processes that have appeared in the top list, keyed by
+    // (pid, starttime). Dropped once a process has been out of the list for a
+    // whole history window.
+    struct ProcessHistory { MetricHistory cpu; unsigned long long lastSeen; };
+    std::map<std::pair<int, long long>, ProcessHistory> processHistory;
+
+    // KB/s per network interface, keyed by name; dropped when the interface goes away.
+    struct NicHistory { MetricHistory rx, tx; unsigned long long lastSeen; };
+    std::map<std::string, NicHistory> nicHistory;
+    // %util per whole disk, same lifetime rule.
+    struct DiskHistory { MetricHistory util; unsigned long long lastSeen; };
+    std::map<std::string, DiskHistory> diskHistory;
+
+    unsigned long long lastSequence = 0;
+    unsigned long long processPass = 0; // process collector runs seen, for ProcessHistory::lastSeen
     float animTime = 0;
-    int currentTab = 0; // 0=Overview, 1=Processes, 2=System Info
-
-    getContextSwitchesAndInterrupts(prevCtxt, prevIntr);
+    int currentTab = 0; // 0=Overview, 1=Processes, 2=Cgroups, 3=System Info, 4=Perf
+    int processSort = 0; // 0=CPU, 1=Top I/O, 2=Memory
+    char psiTriggerSpec[128] = "memory some 150ms in 1s";
+    std::string psiTriggerError;
 
     while (!glfwWindowShouldClose(window)) {
-        glfwPollEvents();
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
-
-        animTime += io.DeltaTime;
-
-        double currentTime = glfwGetTime();
-        if (currentTime - lastUpdateTime >= 1.0) {
-            // CPU
-            CPUStats newCpu = readCPUStats();
-            cpuUsage = calcCPUUsage(oldCpu, newCpu);
-            if (cpuUsage * 100 > peakCpu) peakCpu = cpuUsage * 100;
-
-            // IO Wait percentage
-            long long totalDelta = (newCpu.user + newCpu.nice + newCpu.system + newCpu.idle + newCpu.iowait + newCpu.irq + newCpu.softirq + newCpu.steal)
-                                 - (oldCpu.user + oldCpu.nice + oldCpu.system + oldCpu.idle + oldCpu.iowait + oldCpu.irq + oldCpu.softirq + oldCpu.steal);
-            float ioWaitPct = totalDelta > 0 ? (float)(newCpu.iowait - oldCpu.iowait) / (float)totalDelta * 100.0f : 0;
-
-            // Per-core
-            std::vector<CPUStats> newCoreCpu = readPerCoreCPUStats();
-            perCoreUsage.resize(newCoreCpu.size());
-            for (size_t i = 0; i < newCoreCpu.size() && i < oldCoreCpu.size(); i++) {
-                perCoreUsage[i] = calcCPUUsage(oldCoreCpu[i], newCoreCpu[i]) * 100.0f;
+        governor.wait(window);
+
+        // Hold a reference for the whole frame; the sampler may publish a newer
+        // snapshot meanwhile but never mutates this one.
+        std::shared_ptr<const MetricsSnapshot> snap = sampler.latest();
+        const MetricsSnapshot& m = *snap;
+        if (m.sequence != lastSequence) {
+            // History: each graph gets a point when its collector ran, so it
+            // fills at that collector's interval.
+            if (m.ran(COLLECTOR_CPU)) {
+                cpuHistory.push(m.cpuUsage * 100);
+                ioWaitHistory.push(m.ioWaitPct);
+                if (coreHistory.size() != m.perCoreUsage->size())
+                    coreHistory.assign(m.perCoreUsage->size(), MetricHistory(historySize));
+                for (size_t i = 0; i < m.perCoreUsage->size(); i++) coreHistory[i].push((*m.perCoreUsage)[i]);
+            }
+            if (m.ran(COLLECTOR_MEMORY)) ramHistory.push(m.ramUsagePercent * 100);
+            if (m.ran(COLLECTOR_GPU)) {
+                if (gpuHistory.size() != m.gpus->size())
+                    gpuHistory.resize(m.gpus->size(), MetricHistory(historySize));
+                for (size_t i = 0; i < m.gpus->size(); i++) gpuHistory[i].push((float)std::max(0, (*m.gpus)[i].usagePercent));
+            }
+            if (m.ran(COLLECTOR_PRESSURE)) {
+                cpuPressureHistory.push(m.pressure.cpu.someRecentPercent);
+                memPressureHistory.push(m.pressure.memory.someRecentPercent);
+                ioPressureHistory.push(m.pressure.io.someRecentPercent);
             }
-            oldCoreCpu = newCoreCpu;
-            oldCpu = newCpu;
-
-            cpuTemp = getCPUTemp();
-            cpuFreq = getCPUFrequency();
-            getLoadAverages(loadAvg1, loadAvg5, loadAvg15);
-
-            // Context switches & interrupts
-            long long curCtxt, curIntr;
-            getContextSwitchesAndInterrupts(curCtxt, curIntr);
-            ctxtPerSec = (float)(curCtxt - prevCtxt);
-            intrPerSec = (float)(curIntr - prevIntr);
-            prevCtxt = curCtxt; prevIntr = curIntr;
-
-            // Memory
-            memDetail = getMemoryDetail();
-            ramUsagePercent = memDetail.totalKB > 0 ? (float)(memDetail.totalKB - memDetail.availableKB) / (float)memDetail.totalKB : 0;
-            if (ramUsagePercent * 100 > peakRam) peakRam = ramUsagePercent * 100;
-
-            // Network
-            NetStats newNet = readNetStats();
-            downSpeed = newNet.rxBytes - oldNet.rxBytes;
-            upSpeed = newNet.txBytes - oldNet.txBytes;
-            sessionRx = newNet.rxBytes - startRx;
-            sessionTx = newNet.txBytes - startTx;
-            oldNet = newNet;
-
-            // Disk I/O
-            DiskStats newDisk = readDiskStats();
-            diskReadSpeed = newDisk.readBytes - oldDisk.readBytes;
-            diskWriteSpeed = newDisk.writeBytes - oldDisk.writeBytes;
-            oldDisk = newDisk;
-
-            // Process CPU tracking
-            std::vector<ProcCPUTick> newProcTicks = readAllProcTicks();
-            // total CPU jiffies for process calc
-            CPUStats tmpOld = oldCpu, tmpNew = newCpu; // already saved
-            long long totalCpuJiffies = totalDelta > 0 ? totalDelta : 1;
-            topProcesses = getTopProcesses(oldProcTicks, newProcTicks, totalCpuJiffies, 25);
-            oldProcTicks = newProcTicks;
-
-            // Slow updates (every 5s)
-            slowUpdateCounter++;
-            if (slowUpdateCounter >= 5) {
-                gpu = getGPUInfo();
-                battery = getBatteryInfo();
-                diskPartitions = getDiskPartitions();
-                processCount = getProcessCount();
-                threadCount = getTotalThreadCount();
-                fdCount = getFileDescriptorCount();
-                netConnections = getNetworkConnectionCount();
-                slowUpdateCounter = 0;
+            if (m.ran(COLLECTOR_SYSTEM)) selfCpuHistory.push(m.selfCpuPercent);
+
+            if (m.ran(COLLECTOR_NETWORK)) {
+                netDownHistory.push((float)(m.downSpeed / 1024));
+                netUpHistory.push((float)(m.upSpeed / 1024));
+                for (const auto& nic : *m.interfaces) {
+                    auto it = nicHistory.find(nic.name);
+                    if (it == nicHistory.end())
+                        it = nicHistory.emplace(nic.name, NicHistory{MetricHistory(historySize), MetricHistory(historySize), 0}).first;
+                    it->second.rx.push((float)(nic.rxBytesPerSec / 1024));
+                    it->second.tx.push((float)(nic.txBytesPerSec / 1024));
+                    it->second.lastSeen = m.sequence;
+                }
+                for (auto it = nicHistory.begin(); it != nicHistory.end();)
+                    it = it->second.lastSeen == m.sequence ? std::next(it) : nicHistory.erase(it);
             }
 
-            // History
-            cpuHistory.erase(cpuHistory.begin()); cpuHistory.push_back(cpuUsage * 100);
-            ramHistory.erase(ramHistory.begin()); ramHistory.push_back(ramUsagePercent * 100);
-            gpuHistory.erase(gpuHistory.begin()); gpuHistory.push_back((float)gpu.usagePercent);
-            netDownHistory.erase(netDownHistory.begin()); netDownHistory.push_back((float)(downSpeed / 1024));
-            netUpHistory.erase(netUpHistory.begin()); netUpHistory.push_back((float)(upSpeed / 1024));
-            ioWaitHistory.erase(ioWaitHistory.begin()); ioWaitHistory.push_back(ioWaitPct);
+            if (m.ran(COLLECTOR_DISK)) {
+                for (const auto& dev : *m.diskDevices) {
+                    auto it = diskHistory.find(dev.name);
+                    if (it == diskHistory.end())
+                        it = diskHistory.emplace(dev.name, DiskHistory{MetricHistory(historySize), 0}).first;
+                    it->second.util.push(dev.utilPercent);
+                    it->second.lastSeen = m.sequence;
+                }
+                for (auto it = diskHistory.begin(); it != diskHistory.end();)
+                    it = it->second.lastSeen == m.sequence ? std::next(it) : diskHistory.erase(it);
+            }
 
-            lastUpdateTime = currentTime;
+            if (m.ran(COLLECTOR_PROCESSES)) {
+                processPass++;
+                for (const auto& p : *m.topProcesses) {
+                    auto key = std::make_pair(p.pid, p.starttime);
+                    auto it = processHistory.find(key);
+                    if (it == processHistory.end())
+                        it = processHistory.emplace(key, ProcessHistory{MetricHistory(historySize), 0}).first;
+                    it->second.cpu.push(p.cpuPercent);
+                    it->second.lastSeen = processPass;
+                }
+                for (auto it = processHistory.begin(); it != processHistory.end();) {
+                    if (it->second.lastSeen == processPass) { ++it; continue; }
+                    if (processPass - it->second.lastSeen > (unsigned long long)historySize) { it = processHistory.erase(it); continue; }
+                    it->second.cpu.push(0); // outside the top list, so close to idle
+                    ++it;
+                }
+            }
+            lastSequence = m.sequence;
+            governor.requestRedraw();
         }
 
+        // Histories keep filling while iconified, but nothing is drawn.
+        if (glfwGetWindowAttrib(window, GLFW_ICONIFIED)) continue;
+        if (!governor.beginFrame()) continue;
+
+        long long frameStart = monotonicNanos();
+        PerfCounters frameCounters = perfThreadCounters;
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplGlfw_NewFrame();
+        ImGui::NewFrame();
+
+        if (opt.animate) animTime = (float)glfwGetTime();
+
         // ==================== UI ====================
         ImGui::SetNextWindowPos(ImVec2(0, 0));
         ImGui::SetNextWindowSize(io.DisplaySize);
@@ -1059,7 +637,7 @@ int main(int, char**) {
         ImGui::BeginChild("Header", ImVec2(-1, 55), false);
         {
             ImGui::SetCursorPosY(8);
-            float pulse = 0.7f + 0.3f * sinf(animTime * 2.0f);
+            float pulse = opt.animate ? 0.7f + 0.3f * sinf(animTime * 2.0f) : 1.0f;
             ImVec4 titleColor = ImVec4(0.0f * pulse + 0.2f, 0.85f * pulse, 1.0f * pulse, 1.0f);
 
             ImGui::PushStyleColor(ImGuiCol_Text, titleColor);
@@ -1077,22 +655,22 @@ int main(int, char**) {
 
             ImGui::TextColored(Colors::TextSecondary, "Uptime");
             ImGui::SameLine();
-            ImGui::TextColored(Colors::Cyan, "%s", getUptime().c_str());
+            ImGui::TextColored(Colors::Cyan, "%s", m.uptime.c_str());
 
             ImGui::SameLine(rightOffset + 140);
             ImGui::TextColored(Colors::TextSecondary, "Procs");
             ImGui::SameLine();
-            ImGui::TextColored(Colors::Purple, "%d", processCount);
+            ImGui::TextColored(Colors::Purple, "%d", m.processCount);
 
             ImGui::SameLine(rightOffset + 230);
             ImGui::TextColored(Colors::TextSecondary, "Threads");
             ImGui::SameLine();
-            ImGui::TextColored(Colors::Orange, "%d", threadCount);
+            ImGui::TextColored(Colors::Orange, "%d", m.threadCount);
 
             ImGui::SameLine(rightOffset + 340);
             ImGui::TextColored(Colors::TextSecondary, "FDs");
             ImGui::SameLine();
-            ImGui::TextColored(Colors::Teal, "%d", fdCount);
+            ImGui::TextColored(Colors::Teal, "%d", m.fdCount);
         }
         ImGui::EndChild();
 
@@ -1101,9 +679,9 @@ int main(int, char**) {
         ImGui::PushStyleColor(ImGuiCol_ButtonHovered, ImVec4(0.18f, 0.18f, 0.24f, 1.0f));
         ImGui::PushStyleColor(ImGuiCol_ButtonActive, ImVec4(0.22f, 0.22f, 0.30f, 1.0f));
         {
-            const char* tabNames[] = {"  Overview  ", "  Processes  ", "  System Info  "};
-            ImVec4 tabColors[] = { Colors::Cyan, Colors::Orange, Colors::Purple };
-            for (int i = 0; i < 3; i++) {
+            const char* tabNames[] = {"  Overview  ", "  Processes  ", "  Cgroups  ", "  System Info  ", "  Perf  "};
+            ImVec4 tabColors[] = { Colors::Cyan, Colors::Orange, Colors::Green, Colors::Purple, Colors::Teal };
+            for (int i = 0; i < 5; i++) {
                 if (i > 0) ImGui::SameLine();
                 if (currentTab == i) {
                     ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(tabColors[i].x * 0.2f, tabColors[i].y * 0.2f, tabColors[i].z * 0.2f, 1.0f));
@@ -1127,7 +705,7 @@ int main(int, char**) {
             {
                 // ===== CPU CARD =====
                 ImGui::PushStyleColor(ImGuiCol_ChildBg, Colors::CardBg);
-                float cpuCardH = 210 + (cpuCores > 4 ? 30 : 0);
+                float cpuCardH = 210 + (cpuCores > 4 ? 30 : 0) + (m.coreSched->empty() ? 0 : 40 + (cpuCores > 8 ? 14 : 0));
                 ImGui::BeginChild("CPUCard", ImVec2(-1, cpuCardH), true, ImGuiWindowFlags_NoScrollbar);
                 {
                     DrawCardBorderGlow(Colors::Orange, 0.25f);
@@ -1135,7 +713,7 @@ int main(int, char**) {
 
                     ImGui::TextColored(Colors::TextPrimary, "%s", cpuModel.c_str());
                     ImGui::TextColored(Colors::TextSecondary, "%d Cores (%d Physical)  |  %.0f / %.0f MHz",
-                        cpuCores, physCores, cpuFreq, cpuMaxFreq);
+                        cpuCores, physCores, m.cpuFreq, cpuMaxFreq);
 
                     ImGui::Spacing();
 
@@ -1143,43 +721,62 @@ int main(int, char**) {
                     ImGui::SetColumnWidth(0, 140);
 
                     char cpuVal[16];
-                    snprintf(cpuVal, sizeof(cpuVal), "%.0f%%", cpuUsage * 100);
-                    DrawCircularProgress(cpuUsage, 50, Colors::Orange, "USAGE", cpuVal);
+                    snprintf(cpuVal, sizeof(cpuVal), "%.0f%%", m.cpuUsage * 100);
+                    DrawCircularProgress(m.cpuUsage, 50, Colors::Orange, "USAGE", cpuVal);
 
                     ImGui::NextColumn();
 
                     // Temperature
-                    ImVec4 tempColor = (cpuTemp > 80) ? Colors::Red : (cpuTemp > 60) ? Colors::Yellow : Colors::Green;
+                    ImVec4 tempColor = (m.cpuTemp > 80) ? Colors::Red : (m.cpuTemp > 60) ? Colors::Yellow : Colors::Green;
                     ImGui::TextColored(Colors::TextSecondary, "Temperature");
                     ImGui::SameLine(120);
-                    ImGui::TextColored(tempColor, "%.0f C", cpuTemp);
+                    ImGui::TextColored(tempColor, "%.0f C", m.cpuTemp);
 
                     ImGui::TextColored(Colors::TextSecondary, "Peak CPU");
                     ImGui::SameLine(120);
-                    ImGui::TextColored(Colors::Amber, "%.0f%%", peakCpu);
+                    ImGui::TextColored(Colors::Amber, "%.0f%%", m.peakCpu);
 
                     ImGui::TextColored(Colors::TextSecondary, "IO Wait");
                     ImGui::SameLine(120);
-                    float lastIOWait = ioWaitHistory.back();
+                    float lastIOWait = ioWaitHistory.latest();
                     ImGui::TextColored(lastIOWait > 5 ? Colors::Red : Colors::Green, "%.1f%%", lastIOWait);
 
                     ImGui::Spacing();
-                    MiniGraph("##cpuGraph", cpuHistory.data(), (int)cpuHistory.size(), Colors::Orange, 45);
+                    MiniGraph("##cpuGraph", cpuHistory, Colors::Orange, 45);
 
                     ImGui::Columns(1);
 
                     // Per-core bars
-                    if (!perCoreUsage.empty()) {
+                    if (!m.perCoreUsage->empty()) {
                         ImGui::Spacing();
                         ImGui::TextColored(Colors::TextMuted, "Per-Core:");
-                        int cols = perCoreUsage.size() > 8 ? 8 : (int)perCoreUsage.size();
+                        int cols = m.perCoreUsage->size() > 8 ? 8 : (int)m.perCoreUsage->size();
                         float barW = (ImGui::GetContentRegionAvail().x - (cols - 1) * 4) / cols;
-                        for (int i = 0; i < (int)perCoreUsage.size() && i < 16; i++) {
+                        for (int i = 0; i < (int)m.perCoreUsage->size() && i < 16; i++) {
                             if (i > 0 && i % cols != 0) ImGui::SameLine(0, 4);
                             char coreLabel[8];
                             snprintf(coreLabel, sizeof(coreLabel), "C%d", i);
-                            ImVec4 coreColor = GetUsageColor(perCoreUsage[i]);
-                            DrawGradientProgressBar(perCoreUsage[i] / 100.0f, ImVec2(barW, 10), coreColor, coreColor, nullptr);
+                            ImVec4 coreColor = GetUsageColor((*m.perCoreUsage)[i]);
+                            DrawGradientProgressBar((*m.perCoreUsage)[i] / 100.0f, ImVec2(barW, 10), coreColor, coreColor, nullptr);
+                        }
+                    }
+
+                    // Run-queue delay per core, same layout: a full bar is one task always waiting
+                    if (!m.coreSched->empty()) {
+                        ImGui::Spacing();
+                        float worstDelay = 0;
+                        for (const SchedDelay& d : *m.coreSched) worstDelay = std::max(worstDelay, d.avgDelayMs);
+                        ImGui::TextColored(Colors::TextMuted, "Run-queue delay (ms/s, worst %.2f ms per timeslice):", worstDelay);
+                        int cols = m.coreSched->size() > 8 ? 8 : (int)m.coreSched->size();
+                        float barW = (ImGui::GetContentRegionAvail().x - (cols - 1) * 4) / cols;
+                        for (int i = 0; i < (int)m.coreSched->size() && i < 16; i++) {
+                            if (i > 0 && i % cols != 0) ImGui::SameLine(0, 4);
+                            const SchedDelay& d = (*m.coreSched)[i];
+                            ImVec4 delayColor = d.delayMsPerSec >= 500 ? Colors::Red : d.delayMsPerSec >= 100 ? Colors::Yellow : Colors::Purple;
+                            DrawGradientProgressBar(std::min(1.0f, d.delayMsPerSec / 1000.0f), ImVec2(barW, 6), delayColor, delayColor, nullptr);
+                            if (ImGui::IsItemHovered())
+                                ImGui::SetTooltip("C%d: %.1f ms/s waiting, %.3f ms per timeslice, %.0f timeslices/s", i,
+                                                  d.delayMsPerSec, d.avgDelayMs, d.timeslicesPerSec);
                         }
                     }
                 }
@@ -1195,23 +792,23 @@ int main(int, char**) {
                     DrawCardBorderGlow(Colors::Green, 0.25f);
                     CardHeader("[RAM]", "MEMORY", Colors::Green);
 
-                    float totalGB = memDetail.totalKB / (1024.0f * 1024.0f);
-                    float usedGB = (memDetail.totalKB - memDetail.availableKB) / (1024.0f * 1024.0f);
-                    float cachedGB = (memDetail.cachedKB + memDetail.sreclaimableKB) / (1024.0f * 1024.0f);
-                    float buffersGB = memDetail.buffersKB / (1024.0f * 1024.0f);
+                    float totalGB = m.memDetail.totalKB / (1024.0f * 1024.0f);
+                    float usedGB = (m.memDetail.totalKB - m.memDetail.availableKB) / (1024.0f * 1024.0f);
+                    float cachedGB = (m.memDetail.cachedKB + m.memDetail.sreclaimableKB) / (1024.0f * 1024.0f);
+                    float buffersGB = m.memDetail.buffersKB / (1024.0f * 1024.0f);
 
                     char ramStr[80];
                     snprintf(ramStr, sizeof(ramStr), "%.1f / %.1f GB  (%.0f%%)  |  Peak: %.0f%%",
-                        usedGB, totalGB, ramUsagePercent * 100, peakRam);
+                        usedGB, totalGB, m.ramUsagePercent * 100, m.peakRam);
                     ImGui::TextColored(Colors::TextPrimary, "%s", ramStr);
 
                     ImGui::Spacing();
                     char ramOverlay[16];
-                    snprintf(ramOverlay, sizeof(ramOverlay), "%.0f%%", ramUsagePercent * 100);
-                    DrawGradientProgressBar(ramUsagePercent, ImVec2(-1, 20), Colors::Green, Colors::Cyan, ramOverlay);
+                    snprintf(ramOverlay, sizeof(ramOverlay), "%.0f%%", m.ramUsagePercent * 100);
+                    DrawGradientProgressBar(m.ramUsagePercent, ImVec2(-1, 20), Colors::Green, Colors::Cyan, ramOverlay);
 
                     ImGui::Spacing();
-                    MiniGraph("##ramGraph", ramHistory.data(), (int)ramHistory.size(), Colors::Green, 35);
+                    MiniGraph("##ramGraph", ramHistory, Colors::Green, 35);
 
                     ImGui::Spacing();
                     ImGui::Columns(3, NULL, false);
@@ -1222,14 +819,14 @@ int main(int, char**) {
                     ImGui::TextColored(Colors::Teal, "%.2f GB", buffersGB);
                     ImGui::NextColumn();
                     ImGui::TextColored(Colors::TextSecondary, "Dirty");
-                    ImGui::TextColored(Colors::Orange, "%.1f MB", memDetail.dirtyKB / 1024.0f);
+                    ImGui::TextColored(Colors::Orange, "%.1f MB", m.memDetail.dirtyKB / 1024.0f);
                     ImGui::Columns(1);
 
                     // Swap
-                    if (memDetail.swapTotalKB > 0) {
+                    if (m.memDetail.swapTotalKB > 0) {
                         ImGui::Spacing();
-                        float swapUsed = (memDetail.swapTotalKB - memDetail.swapFreeKB) / (1024.0f * 1024.0f);
-                        float swapTotal = memDetail.swapTotalKB / (1024.0f * 1024.0f);
+                        float swapUsed = (m.memDetail.swapTotalKB - m.memDetail.swapFreeKB) / (1024.0f * 1024.0f);
+                        float swapTotal = m.memDetail.swapTotalKB / (1024.0f * 1024.0f);
                         float swapPct = swapUsed / swapTotal;
                         ImGui::TextColored(Colors::TextSecondary, "Swap: %.1f / %.1f GB", swapUsed, swapTotal);
                         DrawGradientProgressBar(swapPct, ImVec2(-1, 10), Colors::Purple, Colors::Pink, NULL);
@@ -1240,14 +837,21 @@ int main(int, char**) {
 
                 ImGui::Spacing();
 
-                // ===== GPU CARD =====
-                if (gpu.available) {
+                // ===== GPU CARDS (one per GPU) =====
+                for (size_t gi = 0; gi < m.gpus->size(); gi++) {
+                    const GPUInfo& gpu = (*m.gpus)[gi];
+                    if (gi > 0) ImGui::Spacing();
+                    ImGui::PushID((int)gi);
                     ImGui::PushStyleColor(ImGuiCol_ChildBg, Colors::CardBg);
                     ImGui::BeginChild("GPUCard", ImVec2(-1, 180), true, ImGuiWindowFlags_NoScrollbar);
                     {
                         DrawCardBorderGlow(Colors::Purple, 0.25f);
                         CardHeader("[GPU]", "GRAPHICS", Colors::Purple);
 
+                        if (m.gpus->size() > 1) {
+                            ImGui::TextColored(Colors::TextMuted, "#%d", gpu.index);
+                            ImGui::SameLine();
+                        }
                         ImGui::TextColored(Colors::TextPrimary, "%s", gpu.name.c_str());
 
                         ImGui::Spacing();
@@ -1297,10 +901,11 @@ int main(int, char**) {
                         }
 
                         ImGui::Spacing();
-                        MiniGraph("##gpuGraph", gpuHistory.data(), (int)gpuHistory.size(), Colors::Purple, 30);
+                        if (gi < gpuHistory.size()) MiniGraph("##gpuGraph", gpuHistory[gi], Colors::Purple, 30);
                     }
                     ImGui::EndChild();
                     ImGui::PopStyleColor();
+                    ImGui::PopID();
                 }
             }
             ImGui::EndChild();
@@ -1311,8 +916,12 @@ int main(int, char**) {
             ImGui::BeginChild("RightPanel", ImVec2(rightWidth, -30), false);
             {
                 // ===== NETWORK CARD =====
+                int nicCount = 0;
+                for (const auto& nic : *m.interfaces) if (nic.name != "lo") nicCount++;
+                const float nicRowH = 46.0f;
+                float nicListH = std::min(nicCount, 4) * nicRowH;
                 ImGui::PushStyleColor(ImGuiCol_ChildBg, Colors::CardBg);
-                ImGui::BeginChild("NetCard", ImVec2(-1, 220), true, ImGuiWindowFlags_NoScrollbar);
+                ImGui::BeginChild("NetCard", ImVec2(-1, 220 + nicListH + (nicCount ? 10 : 0)), true, ImGuiWindowFlags_NoScrollbar);
                 {
                     DrawCardBorderGlow(Colors::Cyan, 0.25f);
                     CardHeader("[NET]", "NETWORK", Colors::Cyan);
@@ -1320,14 +929,14 @@ int main(int, char**) {
                     ImGui::Columns(2, NULL, false);
 
                     ImGui::TextColored(Colors::TextSecondary, "Download");
-                    ImGui::TextColored(Colors::Cyan, "%s", formatSpeed(downSpeed).c_str());
-                    MiniGraph("##netDown", netDownHistory.data(), (int)netDownHistory.size(), Colors::Cyan, 35);
+                    ImGui::TextColored(Colors::Cyan, "%s", formatSpeed(m.downSpeed).c_str());
+                    MiniGraph("##netDown", netDownHistory, Colors::Cyan, 35);
 
                     ImGui::NextColumn();
 
                     ImGui::TextColored(Colors::TextSecondary, "Upload");
-                    ImGui::TextColored(Colors::Pink, "%s", formatSpeed(upSpeed).c_str());
-                    MiniGraph("##netUp", netUpHistory.data(), (int)netUpHistory.size(), Colors::Pink, 35);
+                    ImGui::TextColored(Colors::Pink, "%s", formatSpeed(m.upSpeed).c_str());
+                    MiniGraph("##netUp", netUpHistory, Colors::Pink, 35);
 
                     ImGui::Columns(1);
 
@@ -1337,13 +946,54 @@ int main(int, char**) {
 
                     ImGui::TextColored(Colors::TextSecondary, "Session Total:");
                     ImGui::SameLine();
-                    ImGui::TextColored(Colors::Cyan, "RX: %s", formatBytes(sessionRx).c_str());
+                    ImGui::TextColored(Colors::Cyan, "RX: %s", formatBytes(m.sessionRx).c_str());
                     ImGui::SameLine();
-                    ImGui::TextColored(Colors::Pink, "TX: %s", formatBytes(sessionTx).c_str());
+                    ImGui::TextColored(Colors::Pink, "TX: %s", formatBytes(m.sessionTx).c_str());
 
                     ImGui::TextColored(Colors::TextSecondary, "TCP Connections:");
                     ImGui::SameLine();
-                    ImGui::TextColored(Colors::Teal, "%d", netConnections);
+                    ImGui::TextColored(Colors::Teal, "%d", m.netConnections);
+                    if (m.sockets.perState) {
+                        ImGui::TextColored(Colors::TextMuted, "EST %d  LISTEN %d  TW %d  UDP %d  UNIX %d",
+                                           m.sockets.tcp[1], m.sockets.tcp[10], m.sockets.tcp[SocketStats::TcpTimeWait],
+                                           m.sockets.udp, m.sockets.unixSockets);
+                    } else {
+                        ImGui::TextColored(Colors::TextMuted, "TW %d  UDP %d",
+                                           m.sockets.tcp[SocketStats::TcpTimeWait], m.sockets.udp);
+                    }
+
+                    // Per-interface rows, physical NICs first; scrolls past four
+                    if (nicCount > 0) {
+                        ImGui::Spacing();
+                        ImGui::Separator();
+                        ImGui::BeginChild("NicList", ImVec2(-1, nicListH), false);
+                        for (const auto& nic : *m.interfaces) {
+                            if (nic.name == "lo") continue;
+                            ImGui::PushID(nic.name.c_str());
+                            ImGui::TextColored(nic.physical ? Colors::TextPrimary : Colors::TextSecondary, "%s", nic.name.c_str());
+                            ImGui::SameLine(100);
+                            ImGui::TextColored(Colors::TextMuted, "%s%s", nic.physical ? "phys" : "virt", nic.up ? "" : " down");
+                            ImGui::SameLine(170);
+                            ImGui::TextColored(Colors::Cyan, "RX %s", formatSpeed(nic.rxBytesPerSec).c_str());
+                            ImGui::SameLine(0, 12);
+                            ImGui::TextColored(Colors::Pink, "TX %s", formatSpeed(nic.txBytesPerSec).c_str());
+                            long long drops = nic.rxDropped + nic.txDropped, errors = nic.rxErrors + nic.txErrors;
+                            if (drops || errors) {
+                                ImGui::SameLine(0, 12);
+                                ImGui::TextColored(errors ? Colors::Red : Colors::Yellow, "drop %lld err %lld", drops, errors);
+                            }
+                            auto hist = nicHistory.find(nic.name);
+                            if (hist != nicHistory.end()) {
+                                ImGui::Columns(2, NULL, false);
+                                MiniGraph("##nicRx", hist->second.rx, Colors::Cyan, 18, FLT_MAX);
+                                ImGui::NextColumn();
+                                MiniGraph("##nicTx", hist->second.tx, Colors::Pink, 18, FLT_MAX);
+                                ImGui::Columns(1);
+                            }
+                            ImGui::PopID();
+                        }
+                        ImGui::EndChild();
+                    }
                 }
                 ImGui::EndChild();
                 ImGui::PopStyleColor();
@@ -1351,19 +1001,44 @@ int main(int, char**) {
                 ImGui::Spacing();
 
                 // ===== DISK I/O CARD =====
+                const float devRowH = 42.0f;
+                float devListH = std::min((int)m.diskDevices->size(), 4) * devRowH;
                 ImGui::PushStyleColor(ImGuiCol_ChildBg, Colors::CardBg);
-                ImGui::BeginChild("DiskIOCard", ImVec2(-1, 80), true, ImGuiWindowFlags_NoScrollbar);
+                ImGui::BeginChild("DiskIOCard", ImVec2(-1, 80 + devListH + (devListH > 0 ? 10 : 0)), true, ImGuiWindowFlags_NoScrollbar);
                 {
                     DrawCardBorderGlow(Colors::Amber, 0.2f);
                     CardHeader("[I/O]", "DISK I/O", Colors::Amber);
 
                     ImGui::Columns(2, NULL, false);
-                    ImGui::TextColored(Colors::Green, "Read: %s", formatSpeed(diskReadSpeed).c_str());
-                    ImGui::TextColored(Colors::TextMuted, "Total: %s", formatBytes(oldDisk.readBytes - startDiskRead).c_str());
+                    ImGui::TextColored(Colors::Green, "Read: %s", formatSpeed(m.diskReadSpeed).c_str());
+                    ImGui::TextColored(Colors::TextMuted, "Total: %s", formatBytes(m.sessionDiskRead).c_str());
                     ImGui::NextColumn();
-                    ImGui::TextColored(Colors::Orange, "Write: %s", formatSpeed(diskWriteSpeed).c_str());
-                    ImGui::TextColored(Colors::TextMuted, "Total: %s", formatBytes(oldDisk.writeBytes - startDiskWrite).c_str());
+                    ImGui::TextColored(Colors::Orange, "Write: %s", formatSpeed(m.diskWriteSpeed).c_str());
+                    ImGui::TextColored(Colors::TextMuted, "Total: %s", formatBytes(m.sessionDiskWrite).c_str());
                     ImGui::Columns(1);
+
+                    // Per-disk iostat -x figures with a %util sparkline; scrolls past four
+                    if (!m.diskDevices->empty()) {
+                        ImGui::Spacing();
+                        ImGui::Separator();
+                        ImGui::BeginChild("DiskDevList", ImVec2(-1, devListH), false);
+                        for (const auto& dev : *m.diskDevices) {
+                            ImGui::PushID(dev.name.c_str());
+                            ImGui::TextColored(dev.physical ? Colors::TextPrimary : Colors::TextSecondary, "%s", dev.name.c_str());
+                            ImGui::SameLine(90);
+                            ImGui::TextColored(Colors::Green, "r/s %.0f", dev.readsPerSec);
+                            ImGui::SameLine(0, 10);
+                            ImGui::TextColored(Colors::Orange, "w/s %.0f", dev.writesPerSec);
+                            ImGui::SameLine(0, 10);
+                            ImGui::TextColored(Colors::TextSecondary, "await %.1f ms  aqu %.2f", dev.awaitMs, dev.queueDepth);
+                            ImGui::SameLine(0, 10);
+                            ImGui::TextColored(GetUsageColor(dev.utilPercent), "%.0f%% util", dev.utilPercent);
+                            auto hist = diskHistory.find(dev.name);
+                            if (hist != diskHistory.end()) MiniGraph("##devUtil", hist->second.util, Colors::Amber, 16);
+                            ImGui::PopID();
+                        }
+                        ImGui::EndChild();
+                    }
                 }
                 ImGui::EndChild();
                 ImGui::PopStyleColor();
@@ -1372,18 +1047,25 @@ int main(int, char**) {
 
                 // ===== STORAGE CARD =====
                 ImGui::PushStyleColor(ImGuiCol_ChildBg, Colors::CardBg);
-                float diskH = 55.0f + diskPartitions.size() * 48.0f;
+                float diskH = 55.0f + m.diskPartitions->size() * 48.0f;
                 if (diskH > 220) diskH = 220;
                 ImGui::BeginChild("DiskCard", ImVec2(-1, diskH), true);
                 {
                     DrawCardBorderGlow(Colors::Yellow, 0.2f);
                     CardHeader("[HDD]", "STORAGE", Colors::Yellow);
 
-                    for (const auto& d : diskPartitions) {
+                    for (const auto& d : *m.diskPartitions) {
                         ImGui::TextColored(Colors::TextPrimary, "%s", d.name.c_str());
                         ImGui::SameLine(120);
                         ImGui::TextColored(Colors::TextMuted, "[%s]", d.fsType.c_str());
                         ImGui::SameLine(180);
+                        if (d.unresponsive) {
+                            // statvfs() has not come back (dead NFS/FUSE server); figures are the last known
+                            ImGui::TextColored(Colors::Red, "not responding");
+                            DrawGradientProgressBar(d.usagePercent, ImVec2(-1, 14), Colors::TextMuted, Colors::TextMuted, "--");
+                            ImGui::Spacing();
+                            continue;
+                        }
                         ImGui::TextColored(Colors::TextSecondary, "%.1f / %.1f GB", d.usedGB, d.totalGB);
 
                         ImVec4 dc = (d.usagePercent > 0.9f) ? Colors::Red :
@@ -1408,27 +1090,86 @@ int main(int, char**) {
 
                     ImGui::TextColored(Colors::TextSecondary, "Load Avg:");
                     ImGui::SameLine();
-                    ImGui::TextColored(GetUsageColor(loadAvg1 / cpuCores * 100), "%.2f", loadAvg1);
+                    ImGui::TextColored(GetUsageColor(m.loadAvg1 / cpuCores * 100), "%.2f", m.loadAvg1);
                     ImGui::SameLine();
                     ImGui::TextColored(Colors::TextSecondary, "/");
                     ImGui::SameLine();
-                    ImGui::TextColored(Colors::Yellow, "%.2f", loadAvg5);
+                    ImGui::TextColored(Colors::Yellow, "%.2f", m.loadAvg5);
                     ImGui::SameLine();
                     ImGui::TextColored(Colors::TextSecondary, "/");
                     ImGui::SameLine();
-                    ImGui::TextColored(Colors::Blue, "%.2f", loadAvg15);
+                    ImGui::TextColored(Colors::Blue, "%.2f", m.loadAvg15);
 
                     ImGui::TextColored(Colors::TextSecondary, "Ctx Switch/s:");
                     ImGui::SameLine();
-                    ImGui::TextColored(Colors::Cyan, "%.0f", ctxtPerSec);
+                    ImGui::TextColored(Colors::Cyan, "%.0f", m.ctxtPerSec);
                     ImGui::SameLine(0, 20);
                     ImGui::TextColored(Colors::TextSecondary, "IRQ/s:");
                     ImGui::SameLine();
-                    ImGui::TextColored(Colors::Orange, "%.0f", intrPerSec);
+                    ImGui::TextColored(Colors::Orange, "%.0f", m.intrPerSec);
 
                     ImGui::TextColored(Colors::TextSecondary, "IO Wait:");
                     ImGui::SameLine();
-                    MiniGraph("##iowait", ioWaitHistory.data(), (int)ioWaitHistory.size(), Colors::Red, 20);
+                    MiniGraph("##iowait", ioWaitHistory, Colors::Red, 20);
+                }
+                ImGui::EndChild();
+                ImGui::PopStyleColor();
+
+                ImGui::Spacing();
+
+                // ===== PRESSURE CARD =====
+                // Share of time tasks were stalled on each resource: unlike the load
+                // average it says which resource is short, and by how much.
+                float pressureHeight = 170 + 18.0f * m.psiTriggers->size() + (psiTriggerError.empty() ? 0 : 18);
+                ImGui::PushStyleColor(ImGuiCol_ChildBg, Colors::CardBg);
+                ImGui::BeginChild("PressureCard", ImVec2(-1, pressureHeight), true, ImGuiWindowFlags_NoScrollbar);
+                {
+                    DrawCardBorderGlow(Colors::Purple, 0.2f);
+                    CardHeader("[PSI]", "PRESSURE STALL", Colors::Purple);
+
+                    struct { const char* label; const char* id; const PressureInfo* info; const MetricHistory* history; ImVec4 color; } rows[] = {
+                        {"CPU", "##psicpu", &m.pressure.cpu, &cpuPressureHistory, Colors::Cyan},
+                        {"Memory", "##psimem", &m.pressure.memory, &memPressureHistory, Colors::Green},
+                        {"IO", "##psiio", &m.pressure.io, &ioPressureHistory, Colors::Orange},
+                    };
+                    if (!m.pressure.cpu.available && !m.pressure.memory.available && !m.pressure.io.available) {
+                        ImGui::TextColored(Colors::TextMuted, "Not available (kernel without CONFIG_PSI, or booted with psi=0)");
+                    }
+                    for (const auto& row : rows) {
+                        if (!row.info->available) continue;
+                        ImGui::TextColored(Colors::TextSecondary, "%s", row.label);
+                        ImGui::SameLine(70);
+                        ImGui::TextColored(GetUsageColor(row.info->some.avg10), "some %5.2f / %5.2f / %5.2f",
+                                           row.info->some.avg10, row.info->some.avg60, row.info->some.avg300);
+                        ImGui::SameLine(0, 12);
+                        ImGui::TextColored(Colors::TextMuted, "full %5.2f", row.info->full.avg10);
+                        ImGui::SameLine(0, 12);
+                        MiniGraph(row.id, *row.history, row.color, 18);
+                    }
+                    ImGui::TextColored(Colors::TextMuted, "avg10 / avg60 / avg300 %%; graphs show each interval");
+
+                    // Triggers: the kernel wakes a poll() as soon as stall time in the
+                    // window crosses the threshold, so episodes are timed to the millisecond.
+                    for (const PsiTriggerInfo& t : *m.psiTriggers) {
+                        ImGui::TextColored(Colors::TextSecondary, "%s", t.spec.c_str());
+                        ImGui::SameLine(260);
+                        if (!t.error.empty()) {
+                            ImGui::TextColored(Colors::Red, "%s", t.error.c_str());
+                        } else if (t.events == 0) {
+                            ImGui::TextColored(Colors::TextMuted, "no events");
+                        } else {
+                            ImGui::TextColored(Colors::Yellow, "%llu events, last %.3f s ago", t.events,
+                                               std::max(0.0, m.timestamp - t.lastEvent));
+                        }
+                    }
+                    ImGui::SetNextItemWidth(-70);
+                    bool submit = ImGui::InputText("##psitrigger", psiTriggerSpec, sizeof(psiTriggerSpec), ImGuiInputTextFlags_EnterReturnsTrue);
+                    ImGui::SameLine();
+                    if (ImGui::Button("Add", ImVec2(60, 0)) || submit) {
+                        psiTriggerError.clear();
+                        sampler.addPsiTrigger(psiTriggerSpec, psiTriggerError);
+                    }
+                    if (!psiTriggerError.empty()) ImGui::TextColored(Colors::Red, "%s", psiTriggerError.c_str());
                 }
                 ImGui::EndChild();
                 ImGui::PopStyleColor();
@@ -1436,36 +1177,36 @@ int main(int, char**) {
                 ImGui::Spacing();
 
                 // ===== BATTERY CARD =====
-                if (battery.available) {
+                if (m.battery.available) {
                     ImGui::PushStyleColor(ImGuiCol_ChildBg, Colors::CardBg);
                     ImGui::BeginChild("BatteryCard", ImVec2(-1, 100), true, ImGuiWindowFlags_NoScrollbar);
                     {
                         DrawCardBorderGlow(Colors::Green, 0.2f);
                         CardHeader("[BAT]", "BATTERY", Colors::Green);
 
-                        ImVec4 bc = (battery.percent < 20) ? Colors::Red :
-                                    (battery.percent < 50) ? Colors::Yellow : Colors::Green;
+                        ImVec4 bc = (m.battery.percent < 20) ? Colors::Red :
+                                    (m.battery.percent < 50) ? Colors::Yellow : Colors::Green;
 
-                        const char* status = battery.charging ? "Charging" : "On Battery";
-                        ImGui::TextColored(bc, "%d%%", battery.percent);
+                        const char* status = m.battery.charging ? "Charging" : "On Battery";
+                        ImGui::TextColored(bc, "%d%%", m.battery.percent);
                         ImGui::SameLine();
                         ImGui::TextColored(Colors::TextSecondary, "%s", status);
 
-                        if (battery.powerWatts > 0) {
+                        if (m.battery.powerWatts > 0) {
                             ImGui::SameLine(0, 20);
-                            ImGui::TextColored(Colors::Orange, "%.1f W", battery.powerWatts);
+                            ImGui::TextColored(Colors::Orange, "%.1f W", m.battery.powerWatts);
                         }
-                        if (battery.estimatedMinutes > 0) {
+                        if (m.battery.estimatedMinutes > 0) {
                             ImGui::SameLine(0, 20);
-                            int hrs = battery.estimatedMinutes / 60;
-                            int mins = battery.estimatedMinutes % 60;
+                            int hrs = m.battery.estimatedMinutes / 60;
+                            int mins = m.battery.estimatedMinutes % 60;
                             ImGui::TextColored(Colors::Cyan, "%dh %dm left", hrs, mins);
                         }
 
                         ImGui::Spacing();
                         char batOvl[16];
-                        snprintf(batOvl, sizeof(batOvl), "%d%%", battery.percent);
-                        DrawGradientProgressBar(battery.percent / 100.0f, ImVec2(-1, 18), bc, Colors::Green, batOvl);
+                        snprintf(batOvl, sizeof(batOvl), "%d%%", m.battery.percent);
+                        DrawGradientProgressBar(m.battery.percent / 100.0f, ImVec2(-1, 18), bc, Colors::Green, batOvl);
                     }
                     ImGui::EndChild();
                     ImGui::PopStyleColor();
@@ -1482,10 +1223,112 @@ int main(int, char**) {
                 CardHeader("[TOP]", "TOP PROCESSES", Colors::Orange);
 
                 ImGui::TextColored(Colors::TextSecondary, "Total: %d processes  |  %d threads  |  %d file descriptors",
-                    processCount, threadCount, fdCount);
+                    m.processCount, m.threadCount, m.fdCount);
+                ImGui::SameLine();
+                ImGui::SetCursorPosX(ImGui::GetWindowWidth() - 275);
+                {
+                    const char* sortNames[] = {"CPU", "Top I/O", "Memory"};
+                    for (int i = 0; i < 3; i++) {
+                        if (i > 0) ImGui::SameLine();
+                        if (processSort == i) ImGui::PushStyleColor(ImGuiCol_Text, Colors::Orange);
+                        if (ImGui::Button(sortNames[i], ImVec2(80, 0))) processSort = i;
+                        if (processSort == i) ImGui::PopStyleColor();
+                    }
+                }
                 ImGui::Spacing();
 
-                if (ImGui::BeginTable("ProcessTable", 6,
+                if (processSort == 2) {
+                    // PSS splits shared pages between their users, so it adds up across processes
+                    // where RSS does not. smaps_rollup is read under a time budget, so rows not
+                    // read yet are ranked and shown by RSS alone.
+                    ImGui::TextColored(Colors::TextMuted, "smaps_rollup: %d read this tick, %d not read yet",
+                        m.procSmapsReads, m.procSmapsPending);
+                    if (ImGui::BeginTable("ProcessMemTable", 7,
+                        ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable |
+                        ImGuiTableFlags_ScrollY | ImGuiTableFlags_SizingStretchProp)) {
+
+                        ImGui::TableSetupColumn("PID", ImGuiTableColumnFlags_WidthFixed, 70);
+                        ImGui::TableSetupColumn("Name", ImGuiTableColumnFlags_WidthStretch);
+                        ImGui::TableSetupColumn("PSS", ImGuiTableColumnFlags_WidthFixed, 90);
+                        ImGui::TableSetupColumn("USS", ImGuiTableColumnFlags_WidthFixed, 90);
+                        ImGui::TableSetupColumn("RSS", ImGuiTableColumnFlags_WidthFixed, 90);
+                        ImGui::TableSetupColumn("Swap", ImGuiTableColumnFlags_WidthFixed, 90);
+                        ImGui::TableSetupColumn("CPU %", ImGuiTableColumnFlags_WidthFixed, 70);
+                        ImGui::TableSetupScrollFreeze(0, 1);
+                        ImGui::TableHeadersRow();
+
+                        for (const auto& p : *m.topMemProcesses) {
+                            ImGui::TableNextRow();
+                            ImGui::TableSetColumnIndex(0);
+                            ImGui::TextColored(Colors::TextMuted, "%d", p.pid);
+                            ImGui::TableSetColumnIndex(1);
+                            ImGui::TextColored(Colors::TextPrimary, "%s", p.name.c_str());
+                            if (p.memSampled) {
+                                ImGui::TableSetColumnIndex(2);
+                                ImGui::TextColored(Colors::Cyan, "%s", formatBytes((long long)(p.pssMB * 1048576)).c_str());
+                                ImGui::TableSetColumnIndex(3);
+                                ImGui::TextColored(Colors::TextSecondary, "%s", formatBytes((long long)(p.ussMB * 1048576)).c_str());
+                            } else {
+                                ImGui::TableSetColumnIndex(2);
+                                ImGui::TextColored(Colors::TextMuted, "...");
+                                ImGui::TableSetColumnIndex(3);
+                                ImGui::TextColored(Colors::TextMuted, "...");
+                            }
+                            ImGui::TableSetColumnIndex(4);
+                            ImGui::TextColored(Colors::TextSecondary, "%s", formatBytes((long long)(p.memMB * 1048576)).c_str());
+                            ImGui::TableSetColumnIndex(5);
+                            if (p.memSampled)
+                                ImGui::TextColored(p.swapMB > 0 ? Colors::Yellow : Colors::TextMuted, "%s",
+                                    formatBytes((long long)(p.swapMB * 1048576)).c_str());
+                            ImGui::TableSetColumnIndex(6);
+                            ImGui::TextColored(GetUsageColor(p.cpuPercent), "%.1f%%", p.cpuPercent);
+                        }
+                        ImGui::EndTable();
+                    }
+                }
+                else if (processSort == 1) {
+                    // Only processes that used CPU this tick (or were already in this list) are
+                    // sampled, so a fully idle process never shows up here.
+                    if (m.topIoProcesses->empty())
+                        ImGui::TextColored(Colors::TextMuted, "No process read or wrote anything this interval.");
+                    else if (ImGui::BeginTable("ProcessIoTable", 8,
+                        ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable |
+                        ImGuiTableFlags_ScrollY | ImGuiTableFlags_SizingStretchProp)) {
+
+                        ImGui::TableSetupColumn("PID", ImGuiTableColumnFlags_WidthFixed, 70);
+                        ImGui::TableSetupColumn("Name", ImGuiTableColumnFlags_WidthStretch);
+                        ImGui::TableSetupColumn("CPU %", ImGuiTableColumnFlags_WidthFixed, 70);
+                        ImGui::TableSetupColumn("Read", ImGuiTableColumnFlags_WidthFixed, 95);
+                        ImGui::TableSetupColumn("Write", ImGuiTableColumnFlags_WidthFixed, 95);
+                        ImGui::TableSetupColumn("Cancelled", ImGuiTableColumnFlags_WidthFixed, 95);
+                        ImGui::TableSetupColumn("Read calls/s", ImGuiTableColumnFlags_WidthFixed, 95);
+                        ImGui::TableSetupColumn("Write calls/s", ImGuiTableColumnFlags_WidthFixed, 95);
+                        ImGui::TableSetupScrollFreeze(0, 1);
+                        ImGui::TableHeadersRow();
+
+                        for (const auto& p : *m.topIoProcesses) {
+                            ImGui::TableNextRow();
+                            ImGui::TableSetColumnIndex(0);
+                            ImGui::TextColored(Colors::TextMuted, "%d", p.pid);
+                            ImGui::TableSetColumnIndex(1);
+                            ImGui::TextColored(Colors::TextPrimary, "%s", p.name.c_str());
+                            ImGui::TableSetColumnIndex(2);
+                            ImGui::TextColored(GetUsageColor(p.cpuPercent), "%.1f%%", p.cpuPercent);
+                            ImGui::TableSetColumnIndex(3);
+                            ImGui::TextColored(Colors::Green, "%s", formatSpeed(p.io.readBytesPerSec).c_str());
+                            ImGui::TableSetColumnIndex(4);
+                            ImGui::TextColored(Colors::Orange, "%s", formatSpeed(p.io.writeBytesPerSec).c_str());
+                            ImGui::TableSetColumnIndex(5);
+                            ImGui::TextColored(Colors::TextSecondary, "%s", formatSpeed(p.io.cancelledWriteBytesPerSec).c_str());
+                            ImGui::TableSetColumnIndex(6);
+                            ImGui::TextColored(Colors::TextSecondary, "%.0f", p.io.syscrPerSec);
+                            ImGui::TableSetColumnIndex(7);
+                            ImGui::TextColored(Colors::TextSecondary, "%.0f", p.io.syscwPerSec);
+                        }
+                        ImGui::EndTable();
+                    }
+                }
+                else if (ImGui::BeginTable("ProcessTable", 8,
                     ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable |
                     ImGuiTableFlags_ScrollY | ImGuiTableFlags_SizingStretchProp)) {
 
@@ -1495,10 +1338,13 @@ int main(int, char**) {
                     ImGui::TableSetupColumn("CPU %", ImGuiTableColumnFlags_WidthFixed, 80);
                     ImGui::TableSetupColumn("Memory", ImGuiTableColumnFlags_WidthFixed, 90);
                     ImGui::TableSetupColumn("Threads", ImGuiTableColumnFlags_WidthFixed, 70);
+                    // Time the process's threads sat runnable on a run queue, per second
+                    ImGui::TableSetupColumn("RQ Delay", ImGuiTableColumnFlags_WidthFixed, 90);
+                    ImGui::TableSetupColumn("CPU History", ImGuiTableColumnFlags_WidthFixed, 140);
                     ImGui::TableSetupScrollFreeze(0, 1);
                     ImGui::TableHeadersRow();
 
-                    for (const auto& p : topProcesses) {
+                    for (const auto& p : *m.topProcesses) {
                         ImGui::TableNextRow();
 
                         ImGui::TableSetColumnIndex(0);
@@ -1524,6 +1370,25 @@ int main(int, char**) {
 
                         ImGui::TableSetColumnIndex(5);
                         ImGui::TextColored(Colors::TextSecondary, "%d", p.threadCount);
+
+                        ImGui::TableSetColumnIndex(6);
+                        if (p.schedSampled) {
+                            const SchedDelay& d = p.sched;
+                            ImGui::TextColored(d.delayMsPerSec >= 100 ? Colors::Red : d.delayMsPerSec >= 10 ? Colors::Yellow : Colors::TextSecondary,
+                                               "%.1f ms/s", d.delayMsPerSec);
+                            if (ImGui::IsItemHovered())
+                                ImGui::SetTooltip("%.3f ms per timeslice, %.0f timeslices/s", d.avgDelayMs, d.timeslicesPerSec);
+                        } else {
+                            ImGui::TextColored(Colors::TextMuted, "-");
+                        }
+
+                        ImGui::TableSetColumnIndex(7);
+                        auto hist = processHistory.find(std::make_pair(p.pid, p.starttime));
+                        if (hist != processHistory.end()) {
+                            char histId[32];
+                            snprintf(histId, sizeof(histId), "##proc%d", p.pid);
+                            MiniGraph(histId, hist->second.cpu, cpuColor, 16);
+                        }
                     }
 
                     ImGui::EndTable();
@@ -1532,8 +1397,107 @@ int main(int, char**) {
             ImGui::EndChild();
             ImGui::PopStyleColor();
         }
-        // ==================== TAB: SYSTEM INFO ====================
+        // ==================== TAB: CGROUPS ====================
         else if (currentTab == 2) {
+            ImGui::PushStyleColor(ImGuiCol_ChildBg, Colors::CardBg);
+            ImGui::BeginChild("CgroupPanel", ImVec2(-1, -30), true);
+            {
+                DrawCardBorderGlow(Colors::Green, 0.25f);
+                CardHeader("[CGR]", "CONTROL GROUPS", Colors::Green);
+
+                if (m.cgroups->empty()) {
+                    ImGui::TextColored(Colors::TextMuted, "No cgroup v2 hierarchy found.");
+                } else {
+                    ImGui::TextColored(Colors::TextSecondary, "%d groups  |  %s", (int)m.cgroups->size(),
+                        m.cgroupsWatched ? "tree followed with inotify" : "tree re-walked every 10 s");
+                    ImGui::Spacing();
+                }
+
+                if (!m.cgroups->empty() && ImGui::BeginTable("CgroupTable", 12,
+                    ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable |
+                    ImGuiTableFlags_ScrollY | ImGuiTableFlags_SizingStretchProp)) {
+
+                    ImGui::TableSetupColumn("Group", ImGuiTableColumnFlags_WidthStretch);
+                    ImGui::TableSetupColumn("CPU %", ImGuiTableColumnFlags_WidthFixed, 70);
+                    ImGui::TableSetupColumn("Throttled", ImGuiTableColumnFlags_WidthFixed, 75);
+                    ImGui::TableSetupColumn("Memory", ImGuiTableColumnFlags_WidthFixed, 85);
+                    ImGui::TableSetupColumn("Anon", ImGuiTableColumnFlags_WidthFixed, 85);
+                    ImGui::TableSetupColumn("File", ImGuiTableColumnFlags_WidthFixed, 85);
+                    ImGui::TableSetupColumn("Read", ImGuiTableColumnFlags_WidthFixed, 90);
+                    ImGui::TableSetupColumn("Write", ImGuiTableColumnFlags_WidthFixed, 90);
+                    ImGui::TableSetupColumn("Pids", ImGuiTableColumnFlags_WidthFixed, 55);
+                    // PSI "some": share of the interval the group's tasks were stalled
+                    ImGui::TableSetupColumn("CPU stall", ImGuiTableColumnFlags_WidthFixed, 70);
+                    ImGui::TableSetupColumn("Mem stall", ImGuiTableColumnFlags_WidthFixed, 70);
+                    ImGui::TableSetupColumn("IO stall", ImGuiTableColumnFlags_WidthFixed, 70);
+                    ImGui::TableSetupScrollFreeze(0, 1);
+                    ImGui::TableHeadersRow();
+
+                    // The list is depth-first, so the tree is drawn in one pass: pop back to
+                    // each row's depth, and skip the rows below a collapsed group.
+                    auto bytesOrDash = [](long long bytes) { return bytes >= 0 ? formatBytes(bytes) : std::string("-"); };
+                    int pushed = 0;
+                    int collapsedDepth = -1;
+                    for (size_t i = 0; i < m.cgroups->size(); i++) {
+                        const CgroupInfo& c = (*m.cgroups)[i];
+                        if (collapsedDepth >= 0 && c.depth > collapsedDepth) continue;
+                        collapsedDepth = -1;
+                        while (pushed > c.depth) { ImGui::TreePop(); pushed--; }
+                        bool hasChildren = i + 1 < m.cgroups->size() && (*m.cgroups)[i + 1].depth > c.depth;
+
+                        ImGui::TableNextRow();
+                        ImGui::TableSetColumnIndex(0);
+                        ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_SpanFullWidth;
+                        if (!hasChildren) flags |= ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen;
+                        if (c.depth == 0) flags |= ImGuiTreeNodeFlags_DefaultOpen;
+                        ImGui::PushStyleColor(ImGuiCol_Text, c.populated ? Colors::TextPrimary : Colors::TextMuted);
+                        bool open = ImGui::TreeNodeEx(c.path.c_str(), flags, "%s", c.name.c_str());
+                        ImGui::PopStyleColor();
+                        if (hasChildren) {
+                            if (open) pushed++;
+                            else collapsedDepth = c.depth;
+                        }
+
+                        ImGui::TableSetColumnIndex(1);
+                        ImGui::TextColored(GetUsageColor(c.cpuPercent), "%.1f%%", c.cpuPercent);
+                        ImGui::TableSetColumnIndex(2);
+                        if (c.throttledPercent > 0)
+                            ImGui::TextColored(Colors::Red, "%.1f%%", c.throttledPercent);
+                        else
+                            ImGui::TextColored(Colors::TextMuted, "-");
+                        ImGui::TableSetColumnIndex(3);
+                        ImGui::TextColored(Colors::Cyan, "%s", bytesOrDash(c.memoryBytes).c_str());
+                        ImGui::TableSetColumnIndex(4);
+                        ImGui::TextColored(Colors::TextSecondary, "%s", bytesOrDash(c.anonBytes).c_str());
+                        ImGui::TableSetColumnIndex(5);
+                        ImGui::TextColored(Colors::TextSecondary, "%s", bytesOrDash(c.fileBytes).c_str());
+                        ImGui::TableSetColumnIndex(6);
+                        ImGui::TextColored(Colors::Green, "%s", formatSpeed(c.ioReadBytesPerSec).c_str());
+                        ImGui::TableSetColumnIndex(7);
+                        ImGui::TextColored(Colors::Orange, "%s", formatSpeed(c.ioWriteBytesPerSec).c_str());
+                        ImGui::TableSetColumnIndex(8);
+                        if (c.pids >= 0)
+                            ImGui::TextColored(Colors::TextSecondary, "%lld", c.pids);
+                        else
+                            ImGui::TextColored(Colors::TextMuted, "-");
+                        const float stalls[3] = {c.cpuPressure, c.memoryPressure, c.ioPressure};
+                        for (int r = 0; r < 3; r++) {
+                            ImGui::TableSetColumnIndex(9 + r);
+                            if (stalls[r] > 0)
+                                ImGui::TextColored(stalls[r] >= 10 ? Colors::Red : Colors::Yellow, "%.1f%%", stalls[r]);
+                            else
+                                ImGui::TextColored(Colors::TextMuted, stalls[r] < 0 ? "-" : "0");
+                        }
+                    }
+                    while (pushed-- > 0) ImGui::TreePop();
+                    ImGui::EndTable();
+                }
+            }
+            ImGui::EndChild();
+            ImGui::PopStyleColor();
+        }
+        // ==================== TAB: SYSTEM INFO ====================
+        else if (currentTab == 3) {
             ImGui::PushStyleColor(ImGuiCol_ChildBg, Colors::CardBg);
             ImGui::BeginChild("SysInfoPanel", ImVec2(-1, -30), true);
             {
@@ -1549,7 +1513,7 @@ int main(int, char**) {
                 DrawStatRow("Architecture", sysInfo.architecture.c_str(), Colors::Orange);
                 DrawStatRow("Hostname", sysInfo.hostname.c_str(), Colors::Purple);
                 DrawStatRow("Username", sysInfo.username.c_str(), Colors::Pink);
-                DrawStatRow("Uptime", getUptime().c_str(), Colors::Yellow);
+                DrawStatRow("Uptime", m.uptime.c_str(), Colors::Yellow);
 
                 ImGui::Spacing();
                 ImGui::Separator();
@@ -1565,25 +1529,43 @@ int main(int, char**) {
                 DrawStatRow("Cores", coreStr, Colors::Cyan);
 
                 char freqStr[64];
-                snprintf(freqStr, sizeof(freqStr), "%.0f MHz (Max: %.0f MHz)", cpuFreq, cpuMaxFreq);
+                snprintf(freqStr, sizeof(freqStr), "%.0f MHz (Max: %.0f MHz)", m.cpuFreq, cpuMaxFreq);
                 DrawStatRow("Frequency", freqStr, Colors::Orange);
 
                 char tempStr[32];
-                snprintf(tempStr, sizeof(tempStr), "%.0f C", cpuTemp);
-                DrawStatRow("Temperature", tempStr, cpuTemp > 80 ? Colors::Red : Colors::Green);
+                snprintf(tempStr, sizeof(tempStr), "%.0f C", m.cpuTemp);
+                DrawStatRow("Temperature", tempStr, m.cpuTemp > 80 ? Colors::Red : Colors::Green);
 
                 char loadStr[64];
-                snprintf(loadStr, sizeof(loadStr), "%.2f / %.2f / %.2f", loadAvg1, loadAvg5, loadAvg15);
+                snprintf(loadStr, sizeof(loadStr), "%.2f / %.2f / %.2f", m.loadAvg1, m.loadAvg5, m.loadAvg15);
                 DrawStatRow("Load Average", loadStr, Colors::Yellow);
 
                 char ctxtStr[64];
-                snprintf(ctxtStr, sizeof(ctxtStr), "%.0f / sec", ctxtPerSec);
+                snprintf(ctxtStr, sizeof(ctxtStr), "%.0f / sec", m.ctxtPerSec);
                 DrawStatRow("Ctx Switches", ctxtStr, Colors::Teal);
 
                 char intrStr[64];
-                snprintf(intrStr, sizeof(intrStr), "%.0f / sec", intrPerSec);
+                snprintf(intrStr, sizeof(intrStr), "%.0f / sec", m.intrPerSec);
                 DrawStatRow("Interrupts", intrStr, Colors::Blue);
 
+                if (!coreHistory.empty()) {
+                    ImGui::Spacing();
+                    ImGui::TextColored(Colors::TextSecondary, "Per-Core History");
+                    ImGui::Columns(4, NULL, false);
+                    for (size_t i = 0; i < coreHistory.size(); i++) {
+                        char coreId[16];
+                        snprintf(coreId, sizeof(coreId), "##core%zu", i);
+                        if (i < m.coreSched->size())
+                            ImGui::TextColored(Colors::TextMuted, "C%zu  %.0f%%  rq %.0f ms/s", i, coreHistory[i].latest(),
+                                               (*m.coreSched)[i].delayMsPerSec);
+                        else
+                            ImGui::TextColored(Colors::TextMuted, "C%zu  %.0f%%", i, coreHistory[i].latest());
+                        MiniGraph(coreId, coreHistory[i], GetUsageColor(coreHistory[i].latest()), 24);
+                        ImGui::NextColumn();
+                    }
+                    ImGui::Columns(1);
+                }
+
                 ImGui::Spacing();
                 ImGui::Separator();
                 ImGui::Spacing();
@@ -1593,39 +1575,39 @@ int main(int, char**) {
                 ImGui::Spacing();
 
                 char totalStr[32];
-                snprintf(totalStr, sizeof(totalStr), "%.1f GB", memDetail.totalKB / (1024.0f * 1024.0f));
+                snprintf(totalStr, sizeof(totalStr), "%.1f GB", m.memDetail.totalKB / (1024.0f * 1024.0f));
                 DrawStatRow("Total RAM", totalStr, Colors::TextPrimary);
 
                 char usedStr[32];
                 snprintf(usedStr, sizeof(usedStr), "%.1f GB (%.0f%%)",
-                    (memDetail.totalKB - memDetail.availableKB) / (1024.0f * 1024.0f), ramUsagePercent * 100);
+                    (m.memDetail.totalKB - m.memDetail.availableKB) / (1024.0f * 1024.0f), m.ramUsagePercent * 100);
                 DrawStatRow("Used", usedStr, Colors::Orange);
 
                 char cachedStr[32];
-                snprintf(cachedStr, sizeof(cachedStr), "%.1f GB", (memDetail.cachedKB + memDetail.sreclaimableKB) / (1024.0f * 1024.0f));
+                snprintf(cachedStr, sizeof(cachedStr), "%.1f GB", (m.memDetail.cachedKB + m.memDetail.sreclaimableKB) / (1024.0f * 1024.0f));
                 DrawStatRow("Cached", cachedStr, Colors::Blue);
 
                 char bufStr[32];
-                snprintf(bufStr, sizeof(bufStr), "%.0f MB", memDetail.buffersKB / 1024.0f);
+                snprintf(bufStr, sizeof(bufStr), "%.0f MB", m.memDetail.buffersKB / 1024.0f);
                 DrawStatRow("Buffers", bufStr, Colors::Teal);
 
                 char activeStr[32];
-                snprintf(activeStr, sizeof(activeStr), "%.1f GB", memDetail.activeKB / (1024.0f * 1024.0f));
+                snprintf(activeStr, sizeof(activeStr), "%.1f GB", m.memDetail.activeKB / (1024.0f * 1024.0f));
                 DrawStatRow("Active", activeStr, Colors::Cyan);
 
                 char inactiveStr[32];
-                snprintf(inactiveStr, sizeof(inactiveStr), "%.1f GB", memDetail.inactiveKB / (1024.0f * 1024.0f));
+                snprintf(inactiveStr, sizeof(inactiveStr), "%.1f GB", m.memDetail.inactiveKB / (1024.0f * 1024.0f));
                 DrawStatRow("Inactive", inactiveStr, Colors::TextSecondary);
 
                 char dirtyStr[32];
-                snprintf(dirtyStr, sizeof(dirtyStr), "%.1f MB", memDetail.dirtyKB / 1024.0f);
+                snprintf(dirtyStr, sizeof(dirtyStr), "%.1f MB", m.memDetail.dirtyKB / 1024.0f);
                 DrawStatRow("Dirty", dirtyStr, Colors::Red);
 
-                if (memDetail.swapTotalKB > 0) {
+                if (m.memDetail.swapTotalKB > 0) {
                     char swapStr[64];
                     snprintf(swapStr, sizeof(swapStr), "%.1f / %.1f GB",
-                        (memDetail.swapTotalKB - memDetail.swapFreeKB) / (1024.0f * 1024.0f),
-                        memDetail.swapTotalKB / (1024.0f * 1024.0f));
+                        (m.memDetail.swapTotalKB - m.memDetail.swapFreeKB) / (1024.0f * 1024.0f),
+                        m.memDetail.swapTotalKB / (1024.0f * 1024.0f));
                     DrawStatRow("Swap", swapStr, Colors::Purple);
                 }
 
@@ -1634,10 +1616,14 @@ int main(int, char**) {
                 ImGui::Spacing();
 
                 // GPU Section
-                if (gpu.available) {
+                if (!m.gpus->empty()) {
                     ImGui::TextColored(Colors::Purple, "--- Graphics ---");
                     ImGui::Spacing();
-                    DrawStatRow("GPU", gpu.name.c_str(), Colors::TextPrimary);
+                }
+                for (const GPUInfo& gpu : *m.gpus) {
+                    char gpuLabel[16];
+                    snprintf(gpuLabel, sizeof(gpuLabel), m.gpus->size() > 1 ? "GPU %d" : "GPU", gpu.index);
+                    DrawStatRow(gpuLabel, gpu.name.c_str(), Colors::TextPrimary);
                     if (gpu.temp > 0) {
                         char gtStr[16]; snprintf(gtStr, sizeof(gtStr), "%d C", gpu.temp);
                         DrawStatRow("GPU Temp", gtStr, gpu.temp > 80 ? Colors::Red : Colors::Green);
@@ -1662,8 +1648,13 @@ int main(int, char**) {
                 // Storage Section
                 ImGui::TextColored(Colors::Yellow, "--- Storage ---");
                 ImGui::Spacing();
-                for (const auto& d : diskPartitions) {
+                for (const auto& d : *m.diskPartitions) {
                     char dStr[80];
+                    if (d.unresponsive) {
+                        snprintf(dStr, sizeof(dStr), "not responding [%s]", d.fsType.c_str());
+                        DrawStatRow(d.name.c_str(), dStr, Colors::Red);
+                        continue;
+                    }
                     snprintf(dStr, sizeof(dStr), "%.1f / %.1f GB (%.0f%%) [%s]",
                         d.usedGB, d.totalGB, d.usagePercent * 100, d.fsType.c_str());
                     DrawStatRow(d.name.c_str(), dStr, d.usagePercent > 0.9f ? Colors::Red : Colors::Green);
@@ -1676,10 +1667,130 @@ int main(int, char**) {
                 // Network Section
                 ImGui::TextColored(Colors::Cyan, "--- Network ---");
                 ImGui::Spacing();
-                DrawStatRow("Session RX", formatBytes(sessionRx).c_str(), Colors::Cyan);
-                DrawStatRow("Session TX", formatBytes(sessionTx).c_str(), Colors::Pink);
-                char connStr[16]; snprintf(connStr, sizeof(connStr), "%d", netConnections);
+                DrawStatRow("Session RX", formatBytes(m.sessionRx).c_str(), Colors::Cyan);
+                DrawStatRow("Session TX", formatBytes(m.sessionTx).c_str(), Colors::Pink);
+                char connStr[16]; snprintf(connStr, sizeof(connStr), "%d", m.netConnections);
                 DrawStatRow("TCP Connections", connStr, Colors::Teal);
+                for (int st = 1; st < SocketStats::TcpStates; st++) {
+                    if (m.sockets.tcp[st] == 0) continue;
+                    char label[32], value[16];
+                    snprintf(label, sizeof(label), "  %s", tcpStateName(st));
+                    snprintf(value, sizeof(value), "%d", m.sockets.tcp[st]);
+                    DrawStatRow(label, value, Colors::TextPrimary);
+                }
+                char udpStr[16]; snprintf(udpStr, sizeof(udpStr), "%d", m.sockets.udp);
+                DrawStatRow("UDP Sockets", udpStr, Colors::Teal);
+                if (m.sockets.unixSockets >= 0) {
+                    char unixStr[16]; snprintf(unixStr, sizeof(unixStr), "%d", m.sockets.unixSockets);
+                    DrawStatRow("Unix Sockets", unixStr, Colors::Teal);
+                }
+            }
+            ImGui::EndChild();
+            ImGui::PopStyleColor();
+        }
+        // ==================== TAB: PERF ====================
+        else if (currentTab == 4) {
+            perfSnapshot(perfStats);
+            ImGui::PushStyleColor(ImGuiCol_ChildBg, Colors::CardBg);
+            ImGui::BeginChild("PerfPanel", ImVec2(-1, -30), true);
+            {
+                DrawCardBorderGlow(Colors::Teal, 0.25f);
+                CardHeader("[PRF]", "MONITOR SELF-PROFILE", Colors::Teal);
+
+                char selfCpuStr[32];
+                snprintf(selfCpuStr, sizeof(selfCpuStr), "%.1f%%", m.selfCpuPercent);
+                DrawStatRow("Monitor CPU", selfCpuStr, GetUsageColor(m.selfCpuPercent));
+                DrawStatRow("Monitor RSS", formatBytes(m.selfRssKB * 1024).c_str(), Colors::Cyan);
+                DrawStatRow("Process Tracking", m.procEvents ? "netlink events" : "/proc scan",
+                            m.procEvents ? Colors::Green : Colors::TextSecondary);
+                {
+                    char ioReads[32];
+                    snprintf(ioReads, sizeof(ioReads), "%d of %d", m.procIoReads, m.processCount);
+                    DrawStatRow("/proc/[pid]/io Reads", ioReads, Colors::TextSecondary);
+                    char smapsReads[48];
+                    snprintf(smapsReads, sizeof(smapsReads), "%d (%d never read)", m.procSmapsReads, m.procSmapsPending);
+                    DrawStatRow("smaps_rollup Reads", smapsReads, Colors::TextSecondary);
+                    char schedReads[32];
+                    snprintf(schedReads, sizeof(schedReads), "%d", m.procSchedReads);
+                    DrawStatRow("schedstat Reads", schedReads, Colors::TextSecondary);
+                }
+                MiniGraph("##selfcpu", selfCpuHistory, Colors::Teal, 36);
+                ImGui::Spacing();
+
+                // Collector schedule; dragging an interval re-arms that collector at once.
+                if (ImGui::BeginTable("CollectorTable", 4,
+                    ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp)) {
+                    ImGui::TableSetupColumn("Collector", ImGuiTableColumnFlags_WidthFixed, 110);
+                    ImGui::TableSetupColumn("Cost", ImGuiTableColumnFlags_WidthFixed, 80);
+                    ImGui::TableSetupColumn("Interval", ImGuiTableColumnFlags_WidthStretch);
+                    ImGui::TableSetupColumn("In Last Sample", ImGuiTableColumnFlags_WidthFixed, 110);
+                    ImGui::TableHeadersRow();
+                    for (int id = 0; id < COLLECTOR_COUNT; id++) {
+                        const CollectorSpec& spec = collectorSpec((CollectorId)id);
+                        ImGui::TableNextRow();
+                        ImGui::TableSetColumnIndex(0);
+                        ImGui::TextColored(Colors::TextPrimary, "%s", spec.name);
+                        ImGui::TableSetColumnIndex(1);
+                        ImGui::TextColored(spec.cost == COST_SLOW ? Colors::Orange : Colors::TextSecondary, "%s",
+                                           collectorCostName(spec.cost));
+                        ImGui::TableSetColumnIndex(2);
+                        float seconds = (float)sampler.collectorInterval((CollectorId)id);
+                        ImGui::PushID(id);
+                        ImGui::SetNextItemWidth(-1);
+                        if (ImGui::SliderFloat("##interval", &seconds, (float)minCollectorInterval(spec.cost), 300.0f,
+                                               "%.2f s", ImGuiSliderFlags_Logarithmic))
+                            sampler.setCollectorInterval((CollectorId)id, seconds);
+                        ImGui::PopID();
+                        ImGui::TableSetColumnIndex(3);
+                        bool ran = m.ran((CollectorId)id);
+                        ImGui::TextColored(ran ? Colors::Green : Colors::TextMuted, "%s", ran ? "yes" : "carried");
+                    }
+                    ImGui::EndTable();
+                }
+                ImGui::Spacing();
+
+                if (ImGui::BeginTable("PerfTable", 8,
+                    ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable |
+                    ImGuiTableFlags_ScrollY | ImGuiTableFlags_SizingStretchProp)) {
+
+                    ImGui::TableSetupColumn("Phase", ImGuiTableColumnFlags_WidthStretch);
+                    ImGui::TableSetupColumn("Calls", ImGuiTableColumnFlags_WidthFixed, 70);
+                    ImGui::TableSetupColumn("Last", ImGuiTableColumnFlags_WidthFixed, 85);
+                    ImGui::TableSetupColumn("p50", ImGuiTableColumnFlags_WidthFixed, 85);
+                    ImGui::TableSetupColumn("p99", ImGuiTableColumnFlags_WidthFixed, 85);
+                    ImGui::TableSetupColumn("Max", ImGuiTableColumnFlags_WidthFixed, 85);
+                    ImGui::TableSetupColumn("Syscalls/call", ImGuiTableColumnFlags_WidthFixed, 100);
+                    ImGui::TableSetupColumn("Allocs/call", ImGuiTableColumnFlags_WidthFixed, 90);
+                    ImGui::TableSetupScrollFreeze(0, 1);
+                    ImGui::TableHeadersRow();
+
+                    for (int id = 0; id < PERF_COUNT; id++) {
+                        const LatencyHistogram& h = perfStats[id];
+                        ImGui::TableNextRow();
+                        ImGui::TableSetColumnIndex(0);
+                        bool render = id >= PERF_FRAME_BUILD;
+                        ImGui::TextColored(render ? Colors::Purple : Colors::TextPrimary, "%s", perfName((PerfId)id));
+                        ImGui::TableSetColumnIndex(1);
+                        ImGui::TextColored(Colors::TextMuted, "%llu", h.samples);
+                        if (h.samples == 0) continue;
+
+                        long long p99 = h.percentile(0.99);
+                        ImGui::TableSetColumnIndex(2);
+                        ImGui::TextColored(Colors::TextSecondary, "%s", formatDuration(h.lastNs).c_str());
+                        ImGui::TableSetColumnIndex(3);
+                        ImGui::TextColored(Colors::Cyan, "%s", formatDuration(h.percentile(0.50)).c_str());
+                        ImGui::TableSetColumnIndex(4);
+                        ImGui::TextColored(p99 > 10000000LL ? Colors::Orange : Colors::Cyan, "%s", formatDuration(p99).c_str());
+                        ImGui::TableSetColumnIndex(5);
+                        ImGui::TextColored(Colors::TextSecondary, "%s", formatDuration(h.maxNs).c_str());
+                        ImGui::TableSetColumnIndex(6);
+                        ImGui::TextColored(Colors::Teal, "%.1f", (double)h.syscalls / h.samples);
+                        ImGui::TableSetColumnIndex(7);
+                        ImGui::TextColored(Colors::Pink, "%.1f", (double)h.allocations / h.samples);
+                    }
+
+                    ImGui::EndTable();
+                }
             }
             ImGui::EndChild();
             ImGui::PopStyleColor();
@@ -1696,17 +1807,19 @@ int main(int, char**) {
             ImGui::SameLine(0, 20);
             ImGui::TextColored(Colors::TextMuted, "|");
             ImGui::SameLine(0, 20);
-            ImGui::TextColored(Colors::TextSecondary, "CPU: %.0f%%", cpuUsage * 100);
+            ImGui::TextColored(Colors::TextSecondary, "CPU: %.0f%%", m.cpuUsage * 100);
             ImGui::SameLine(0, 15);
-            ImGui::TextColored(Colors::TextSecondary, "RAM: %.0f%%", ramUsagePercent * 100);
+            ImGui::TextColored(Colors::TextSecondary, "RAM: %.0f%%", m.ramUsagePercent * 100);
             ImGui::SameLine(0, 15);
-            ImGui::TextColored(Colors::TextSecondary, "Load: %.2f", loadAvg1);
-            if (gpu.available) {
+            ImGui::TextColored(Colors::TextSecondary, "Load: %.2f", m.loadAvg1);
+            for (const GPUInfo& gpu : *m.gpus) {
                 ImGui::SameLine(0, 15);
-                ImGui::TextColored(Colors::TextSecondary, "GPU: %d%%", gpu.usagePercent);
+                if (m.gpus->size() > 1) ImGui::TextColored(Colors::TextSecondary, "GPU%d: %d%%", gpu.index, gpu.usagePercent);
+                else ImGui::TextColored(Colors::TextSecondary, "GPU: %d%%", gpu.usagePercent);
             }
             ImGui::SameLine(ImGui::GetWindowWidth() - 160);
-            ImGui::TextColored(Colors::TextMuted, "Update: 1s | History: %ds", HISTORY_SIZE);
+            double cpuInterval = sampler.collectorInterval(COLLECTOR_CPU);
+            ImGui::TextColored(Colors::TextMuted, "Update: %.3gs | History: %.0fs", cpuInterval, historySize * cpuInterval);
             ImGui::EndChild();
             ImGui::PopStyleColor();
         }
@@ -1715,15 +1828,23 @@ int main(int, char**) {
 
         // Render
         ImGui::Render();
-        int display_w, display_h;
-        glfwGetFramebufferSize(window, &display_w, &display_h);
-        glViewport(0, 0, display_w, display_h);
-        glClearColor(0.04f, 0.04f, 0.07f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-        glfwSwapBuffers(window);
+        perfRecord(PERF_FRAME_BUILD, monotonicNanos() - frameStart,
+                   { perfThreadCounters.syscalls - frameCounters.syscalls,
+                     perfThreadCounters.allocations - frameCounters.allocations });
+        {
+            PerfTimer t(PERF_FRAME_DRAW);
+            int display_w, display_h;
+            glfwGetFramebufferSize(window, &display_w, &display_h);
+            glViewport(0, 0, display_w, display_h);
+            glClearColor(0.04f, 0.04f, 0.07f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
+        { PerfTimer t(PERF_FRAME_PRESENT); glfwSwapBuffers(window); }
     }
 
+    sampler.stop();
+
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -0,0 +1,447 @@
+// CekyMonitor Server - local metrics daemon
+// Samples with the same collectors as the monitor and serves the latest snapshot
+// and metric history over loopback HTTP and a Unix domain socket (also HTTP, so
+// `curl --unix-socket` works). Responses are serialised once per tick and shared
+// by every client, so polling never triggers a /proc rescan.
+//
+// Endpoints:  GET /snapshot       latest sample as JSON (also GET /)
+//             GET /snapshot.bin   latest sample as a length-prefixed binary record
+//             GET /history        metric histories as JSON arrays, oldest first
+
+#include "collectors.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// ==================== OPTIONS ====================
+struct ServerOptions {
+    int port = 9870;                                  // loopback HTTP, 0 = disabled
+    std::string socketPath = "/tmp/cekymonitor.sock"; // empty = disabled
+    double interval = 1.0;
+    int historySize = 300;
+    std::string procRoot, sysRoot;                    // empty = /proc, /sys
+    std::string nvidiaSmi;                            // empty = from PATH
+    bool procEvents = false;                          // proc connector pid tracking
+    bool sockstat = false;                            // socket summary only
+    std::vector<std::string> psiTriggers;             // "memory some 150ms in 1s" ...
+    std::vector<std::string> collectorIntervals;      // "network=0.1" ...
+};
+
+static ServerOptions parseServerOptions(int argc, char** argv) {
+    ServerOptions opt;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--port" && i + 1 < argc) {
+            opt.port = atoi(argv[++i]);
+        } else if (arg == "--socket" && i + 1 < argc) {
+            opt.socketPath = argv[++i];
+        } else if (arg == "--interval" && i + 1 < argc) {
+            opt.interval = std::max(0.05, atof(argv[++i]));
+        } else if (arg == "--history" && i + 1 < argc) {
+            opt.historySize = std::max(10, std::min(atoi(argv[++i]), 86400));
+        } else if (arg == "--proc-root" && i + 1 < argc) {
+            opt.procRoot = argv[++i];
+        } else if (arg == "--sys-root" && i + 1 < argc) {
+            opt.sysRoot = argv[++i];
+        } else if (arg == "--nvidia-smi" && i + 1 < argc) {
+            opt.nvidiaSmi = argv[++i];
+        } else if (arg == "--proc-events") {
+            opt.procEvents = true;
+        } else if (arg == "--sockstat") {
+            opt.sockstat = true;
+        } else if (arg == "--psi-trigger" && i + 1 < argc) {
+            opt.psiTriggers.push_back(argv[++i]);
+        } else if (arg == "--collector-interval" && i + 1 < argc) {
+            opt.collectorIntervals.push_back(argv[++i]);
+        } else if (arg == "--help" || arg == "-h") {
+            printf("Usage: server [--port N] [--socket PATH] [--interval SECONDS] [--history SAMPLES]\n"
+                   "              [--proc-root DIR] [--sys-root DIR] [--nvidia-smi PATH] [--proc-events]\n"
+                   "              [--sockstat] [--psi-trigger \"RESOURCE some|full STALL in WINDOW [CGROUP]\"]...\n"
+                   "              [--collector-interval NAME=SECONDS]...\n"
+                   "       --port 0 or --socket '' disables that listener\n");
+            exit(0);
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", arg.c_str());
+        }
+    }
+    return opt;
+}
+
+// ==================== RESPONSE CACHE ====================
+typedef std::shared_ptr<const std::string> Response;
+
+// Complete HTTP responses (headers + body), rebuilt once per tick. Clients that are
+// mid-write keep their own reference, so a new tick never disturbs them.
+struct ResponseCache {
+    Response snapshotJson, snapshotBinary, history, notFound, badRequest;
+};
+
+static Response makeResponse(const char* status, const char* contentType, const std::string& body) {
+    auto r = std::make_shared<std::string>();
+    r->reserve(body.size() + 160);
+    char header[160];
+    int n = snprintf(header, sizeof(header),
+                     "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\nCache-Control: no-store\r\n\r\n",
+                     status, contentType, body.size());
+    r->append(header, n);
+    r->append(body);
+    return r;
+}
+
+// Histories kept by the daemon itself; the sampler only publishes single snapshots.
+struct ServerHistory {
+    explicit ServerHistory(int size)
+        : cpu(size), ram(size), ioWait(size), netDown(size), netUp(size), diskRead(size), diskWrite(size) {}
+
+    // Each series gets a point only when its collector ran for this snapshot.
+    void push(const MetricsSnapshot& m) {
+        if (m.ran(COLLECTOR_CPU)) {
+            cpu.push(m.cpuUsage * 100);
+            ioWait.push(m.ioWaitPct);
+        }
+        if (m.ran(COLLECTOR_MEMORY)) ram.push(m.ramUsagePercent * 100);
+        if (m.ran(COLLECTOR_NETWORK)) {
+            netDown.push((float)m.downSpeed);
+            netUp.push((float)m.upSpeed);
+        }
+        if (m.ran(COLLECTOR_DISK)) {
+            diskRead.push((float)m.diskReadSpeed);
+            diskWrite.push((float)m.diskWriteSpeed);
+        }
+    }
+
+    MetricHistory cpu, ram, ioWait, netDown, netUp, diskRead, diskWrite;
+};
+
+static void appendHistoryArray(std::string& out, const char* name, const MetricHistory& h) {
+    out += '"';
+    out += name;
+    out += "\":[";
+    char num[32];
+    for (int i = 0; i < h.size(); i++) {
+        int n = snprintf(num, sizeof(num), i ? ",%.6g" : "%.6g", h.at(i));
+        out.append(num, n);
+    }
+    out += ']';
+}
+
+static void rebuildResponses(ResponseCache& cache, const MetricsSnapshot& m, const ServerHistory& h,
+                             double interval, std::string& scratch) {
+    scratch.clear();
+    appendSnapshotJson(scratch, m);
+    cache.snapshotJson = makeResponse("200 OK", "application/json", scratch);
+
+    scratch.clear();
+    appendSnapshotBinary(scratch, m);
+    cache.snapshotBinary = makeResponse("200 OK", "application/octet-stream", scratch);
+
+    scratch.clear();
+    char head[96];
+    snprintf(head, sizeof(head), "{\"seq\":%llu,\"interval\":%.3f,\"length\":%d,", m.sequence, interval, h.cpu.size());
+    scratch += head;
+    appendHistoryArray(scratch, "cpu", h.cpu);            scratch += ',';
+    appendHistoryArray(scratch, "ram", h.ram);            scratch += ',';
+    appendHistoryArray(scratch, "iowait", h.ioWait);      scratch += ',';
+    appendHistoryArray(scratch, "net_rx_bps", h.netDown); scratch += ',';
+    appendHistoryArray(scratch, "net_tx_bps", h.netUp);   scratch += ',';
+    appendHistoryArray(scratch, "disk_read_bps", h.diskRead); scratch += ',';
+    appendHistoryArray(scratch, "disk_write_bps", h.diskWrite);
+    scratch += "}\n";
+    cache.history = makeResponse("200 OK", "application/json", scratch);
+}
+
+// ==================== CONNECTIONS ====================
+struct Client {
+    std::string in;       // bytes received but not yet parsed
+    Response out;         // response being written, if any
+    size_t outOffset = 0;
+    bool closeAfterWrite = false;
+    bool peerClosed = false; // recv saw EOF: only wait for writability from now on
+};
+
+static const size_t MaxRequestBytes = 8192;
+
+static int listenTcp(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int listenUnix(const std::string& path) {
+    sockaddr_un addr = {};
+    if (path.size() >= sizeof(addr.sun_path)) { errno = ENAMETOOLONG; return -1; }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    unlink(path.c_str()); // stale socket from a previous run
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Picks the cached response for one request head ("GET /path HTTP/1.1 ...").
+static Response route(const ResponseCache& cache, const std::string& head, bool& closeAfter) {
+    size_t sp1 = head.find(' ');
+    size_t sp2 = sp1 == std::string::npos ? sp1 : head.find(' ', sp1 + 1);
+    if (sp2 == std::string::npos || head.compare(0, sp1, "GET") != 0) {
+        closeAfter = true;
+        return cache.badRequest;
+    }
+    std::string path = head.substr(sp1 + 1, sp2 - sp1 - 1);
+    size_t q = path.find('?');
+    if (q != std::string::npos) path.resize(q);
+
+    // HTTP/1.0 closes unless asked otherwise; HTTP/1.1 keeps alive unless asked to close.
+    bool http10 = head.compare(sp2 + 1, 8, "HTTP/1.0") == 0;
+    bool wantsClose = head.find("Connection: close") != std::string::npos ||
+                      head.find("connection: close") != std::string::npos;
+    bool wantsKeepAlive = head.find("Connection: keep-alive") != std::string::npos ||
+                          head.find("connection: keep-alive") != std::string::npos;
+    closeAfter = wantsClose || (http10 && !wantsKeepAlive);
+
+    if (path == "/" || path == "/snapshot") return cache.snapshotJson;
+    if (path == "/snapshot.bin") return cache.snapshotBinary;
+    if (path == "/history") return cache.history;
+    return cache.notFound;
+}
+
+// ==================== MAIN ====================
+int main(int argc, char** argv) {
+    ServerOptions opt = parseServerOptions(argc, argv);
+    setHostRoots(opt.procRoot, opt.sysRoot);
+    setNvidiaSmiCommand(opt.nvidiaSmi);
+    signal(SIGPIPE, SIG_IGN);
+
+    // Block the shutdown signals before the sampler thread starts so it inherits
+    // the mask and they are only ever delivered through the signalfd.
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+    int sigFd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+
+    int tcpFd = -1, unixFd = -1;
+    if (opt.port > 0) {
+        tcpFd = listenTcp(opt.port);
+        if (tcpFd < 0) fprintf(stderr, "Cannot listen on 127.0.0.1:%d: %s\n", opt.port, strerror(errno));
+    }
+    if (!opt.socketPath.empty()) {
+        unixFd = listenUnix(opt.socketPath);
+        if (unixFd < 0) fprintf(stderr, "Cannot listen on %s: %s\n", opt.socketPath.c_str(), strerror(errno));
+    }
+    if (tcpFd < 0 && unixFd < 0) return 1;
+
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    int tickFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    auto watch = [&](int fd, uint32_t events) {
+        epoll_event ev = {};
+        ev.events = events;
+        ev.data.fd = fd;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+    };
+    for (int fd : {tcpFd, unixFd, tickFd, sigFd})
+        if (fd >= 0) watch(fd, EPOLLIN);
+
+    ResponseCache cache;
+    cache.notFound = makeResponse("404 Not Found", "text/plain", "not found\n");
+    cache.badRequest = makeResponse("400 Bad Request", "text/plain", "bad request\n");
+    ServerHistory history(opt.historySize);
+    std::string scratch;
+    rebuildResponses(cache, MetricsSnapshot(), history, opt.interval, scratch);
+
+    Sampler sampler(opt.interval);
+    sampler.setUseProcEvents(opt.procEvents);
+    sampler.setSocketSummary(opt.sockstat);
+    for (const std::string& spec : opt.psiTriggers) {
+        std::string error;
+        if (!sampler.addPsiTrigger(spec, error)) fprintf(stderr, "PSI trigger \"%s\": %s\n", spec.c_str(), error.c_str());
+    }
+    for (const std::string& spec : opt.collectorIntervals) {
+        CollectorId id;
+        double seconds;
+        std::string error;
+        if (parseCollectorInterval(spec, id, seconds, error)) sampler.setCollectorInterval(id, seconds);
+        else fprintf(stderr, "Collector interval \"%s\": %s\n", spec.c_str(), error.c_str());
+    }
+    sampler.setOnPublish([tickFd] {
+        uint64_t one = 1;
+        ssize_t n = write(tickFd, &one, sizeof(one));
+        (void)n;
+    });
+    sampler.start();
+
+    if (tcpFd >= 0) printf("✓ Serving http://127.0.0.1:%d/snapshot\n", opt.port);
+    if (unixFd >= 0) printf("✓ Serving unix:%s\n", opt.socketPath.c_str());
+    fflush(stdout);
+
+    std::unordered_map<int, Client> clients;
+    unsigned long long lastSequence = 0;
+
+    auto closeClient = [&](int fd) {
+        epoll_ctl(epfd, EPOLL_CTL_DEL, fd, NULL);
+        close(fd);
+        clients.erase(fd);
+    };
+
+    // Writes as much of the pending response as the socket takes. Returns false if
+    // the client was closed.
+    auto flush = [&](int fd, Client& c) {
+        while (c.out) {
+            ssize_t n = send(fd, c.out->data() + c.outOffset, c.out->size() - c.outOffset, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    epoll_event ev = {};
+                    ev.events = c.peerClosed ? EPOLLOUT : EPOLLIN | EPOLLOUT;
+                    ev.data.fd = fd;
+                    epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &ev);
+                    return true;
+                }
+                closeClient(fd);
+                return false;
+            }
+            c.outOffset += n;
+            if (c.outOffset < c.out->size()) continue;
+            c.out.reset();
+            c.outOffset = 0;
+            if (c.closeAfterWrite) { closeClient(fd); return false; }
+        }
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &ev);
+        return true;
+    };
+
+    // Answers the next complete request in c.in, if there is one and no response
+    // is still being written (keeps pipelined responses in order).
+    auto serve = [&](int fd, Client& c) {
+        while (!c.out) {
+            size_t endOfHead = c.in.find("\r\n\r\n");
+            if (endOfHead == std::string::npos) {
+                if (c.in.size() > MaxRequestBytes) { closeClient(fd); return; }
+                return;
+            }
+            std::string head = c.in.substr(0, endOfHead);
+            c.in.erase(0, endOfHead + 4);
+            bool closeAfter = false;
+            c.out = route(cache, head, closeAfter);
+            c.outOffset = 0;
+            c.closeAfterWrite = closeAfter;
+            if (!flush(fd, c)) return;
+        }
+    };
+
+    bool stopping = false;
+    std::vector<epoll_event> events(256);
+    while (!stopping) {
+        int n = epoll_wait(epfd, events.data(), (int)events.size(), -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            int fd = events[i].data.fd;
+            uint32_t ev = events[i].events;
+
+            if (fd == sigFd) {
+                stopping = true;
+            } else if (fd == tickFd) {
+                uint64_t count;
+                while (read(tickFd, &count, sizeof(count)) > 0) {}
+                std::shared_ptr<const MetricsSnapshot> snap = sampler.latest();
+                if (snap->sequence == lastSequence) continue;
+                lastSequence = snap->sequence;
+                history.push(*snap);
+                rebuildResponses(cache, *snap, history, sampler.collectorInterval(COLLECTOR_CPU), scratch);
+            } else if (fd == tcpFd || fd == unixFd) {
+                for (;;) {
+                    int cfd = accept4(fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                    if (cfd < 0) break;
+                    if (fd == tcpFd) {
+                        int one = 1;
+                        setsockopt(cfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                    }
+                    clients[cfd];
+                    watch(cfd, EPOLLIN);
+                }
+            } else {
+                auto it = clients.find(fd);
+                if (it == clients.end()) continue;
+                Client& c = it->second;
+                if (ev & (EPOLLERR | EPOLLHUP)) { closeClient(fd); continue; }
+                if (ev & EPOLLOUT) {
+                    if (!flush(fd, c)) continue;
+                    // The write that blocked may have held back pipelined requests.
+                    serve(fd, c);
+                    if (!clients.count(fd)) continue;
+                    if (c.peerClosed && !c.out) { closeClient(fd); continue; }
+                }
+                if (ev & EPOLLIN) {
+                    char buf[4096];
+                    bool closed = false;
+                    for (;;) {
+                        ssize_t r = recv(fd, buf, sizeof(buf), 0);
+                        if (r > 0) { c.in.append(buf, r); continue; }
+                        if (r == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) closed = true;
+                        break;
+                    }
+                    serve(fd, c);
+                    // Peer shut down its side: answer what it already sent, then close.
+                    // EOF stays readable, so stop polling for input or epoll spins.
+                    if (closed && clients.count(fd)) {
+                        if (c.out) {
+                            c.peerClosed = true;
+                            epoll_event out = {};
+                            out.events = EPOLLOUT;
+                            out.data.fd = fd;
+                            epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &out);
+                        } else {
+                            closeClient(fd);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    sampler.stop();
+    for (auto& kv : clients) close(kv.first);
+    if (tcpFd >= 0) close(tcpFd);
+    if (unixFd >= 0) { close(unixFd); unlink(opt.socketPath.c_str()); }
+    close(tickFd);
+    close(epfd);
+    if (sigFd >= 0) close(sigFd);
+    return 0;
+}